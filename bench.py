@@ -0,0 +1,333 @@
+#! /usr/bin/env python3
+""" Benchmarks for the hot paths of docker-systemctl-replacement """
+
+__copyright__ = "(C) Guido Draheim, licensed under the EUPL"""
+__version__ = "1.5.4505"
+
+## NOTE:
+## The benchmarks 1000...1999 run systemctl.py as a command on a --root=subdir
+## The benchmarks 2000...2999 import systemctl.py to time single functions
+## The benchmarks 3000...3999 start and stop real processes below the --root
+
+from typing import Any, Callable, Dict, List, Optional, Tuple
+import importlib.util
+import subprocess
+import os
+import os.path
+import time
+import datetime
+import shutil
+import logging
+import sys
+from fnmatch import fnmatchcase as fnmatch
+
+logg = logging.getLogger("BENCH")
+_python = sys.executable or "/usr/bin/python3"
+_systemctl_py = "files/docker/systemctl3.py"
+_bin_sleep = "/bin/sleep"
+_benchdir = "tmp/tmp.bench"
+_output = "bench_output.txt"
+UNITS = 300 # synthetic units in the --root (each with a drop-in)
+PROCS = 3000 # synthetic processes in the fake /proc
+ROUNDS = 5 # the minimum and the median are reported
+LOGLINES = 100000
+KEEP = 0
+
+def text_file(filename: str, content: str) -> None:
+    filedir = os.path.dirname(filename)
+    if not os.path.isdir(filedir):
+        os.makedirs(filedir)
+    f = open(filename, "w")
+    f.write(content)
+    f.close()
+def exec_file(filename: str, content: str) -> None:
+    text_file(filename, content)
+    os.chmod(filename, 0o755)
+def os_path(root: Optional[str], path: str) -> str:
+    if not root:
+        return path
+    if not path:
+        return path
+    while path.startswith(os.path.sep):
+       path = path[1:]
+    return os.path.join(root, path)
+def median(values: List[float]) -> float:
+    ordered = sorted(values)
+    return ordered[len(ordered) // 2]
+
+def make_units_root(root: str, units: int) -> List[str]:
+    """ zz0000.service ... with an After= chain, a Requires= on every tenth
+        unit and an override.conf drop-in for each of them """
+    names = []
+    for num in range(units):
+        name = "zz%04i.service" % num
+        after = num and "After=zz%04i.service\n" % (num - 1) or ""
+        requires = num >= 10 and "Requires=zz%04i.service\n" % (num - num % 10 - 10) or ""
+        text_file(os_path(root, "/etc/systemd/system/" + name),
+            "[Unit]\nDescription=Bench %i\n%s%s"
+            "[Service]\nType=simple\nExecStart=%s 999\n"
+            "[Install]\nWantedBy=multi-user.target\n" % (num, after, requires, _bin_sleep))
+        text_file(os_path(root, "/etc/systemd/system/%s.d/override.conf" % name),
+            "[Service]\nEnvironment=BENCH=%i\nTimeoutStopSec=7\n" % num)
+        names.append(name)
+    return names
+def make_proc_tree(procdir: str, procs: int, fanout: int = 7) -> None:
+    """ pid 1 ... pid M as a tree below pid 1 with fanout children each - only
+        the stat and cmdline files are written as those are read by ProcTable """
+    for pid in range(1, procs + 1):
+        ppid = pid > 1 and (pid - 2) // fanout + 1 or 0
+        fields = [ "S", str(ppid) ] + [ "0" ] * 17 + [ str(1000 + pid) ] + [ "0" ] * 30
+        text_file(os.path.join(procdir, str(pid), "stat"), "%i (bench%i) %s\n" % (pid, pid, " ".join(fields)))
+        text_file(os.path.join(procdir, str(pid), "cmdline"), "bench\0%i\0" % pid)
+def load_systemctl(filename: str) -> Any:
+    """ import systemctl.py as a module - it does not run its main() """
+    spec = importlib.util.spec_from_file_location("systemctl_bench", filename)
+    assert spec is not None and spec.loader is not None
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module) # type: ignore
+    return module
+
+class BenchResult:
+    def __init__(self, name: str, size: int, seconds: List[float], unit: str = "s", scale: float = 1.) -> None:
+        self.name = name
+        self.size = size
+        self.seconds = seconds
+        self.unit = unit
+        self.scale = scale # items per round for the throughput
+    def best(self) -> float:
+        return min(self.seconds)
+    def middle(self) -> float:
+        return median(self.seconds)
+    def value(self, seconds: float) -> float:
+        if self.unit == "s":
+            return seconds
+        return self.scale / max(seconds, 1e-9)
+    def line(self, stamp: str) -> str:
+        return "%s %s py%i.%i %s %i %.6f %.6f %s" % (stamp, __version__, sys.version_info[0], sys.version_info[1],
+            self.name, self.size, self.value(self.best()), self.value(self.middle()), self.unit)
+
+class SystemctlBench:
+    """ each bench_NNNN method returns the seconds for each of the rounds """
+    def __init__(self, rounds: int = ROUNDS, units: int = UNITS, procs: int = PROCS) -> None:
+        self.rounds = rounds
+        self.units = units
+        self.procs = procs
+        self.root = os.path.abspath(_benchdir)
+        self.procdir = os_path(self.root, "/proc")
+        self.names: List[str] = []
+        self.module: Any = None
+    def setup(self) -> None:
+        if os.path.isdir(self.root):
+            shutil.rmtree(self.root)
+        started = time.time()
+        self.names = make_units_root(self.root, self.units)
+        make_proc_tree(self.procdir, self.procs)
+        logg.info("generated %i units and %i procs in %.3fs at %s", self.units, self.procs, time.time() - started, self.root)
+    def teardown(self) -> None:
+        if not KEEP and os.path.isdir(self.root):
+            shutil.rmtree(self.root)
+    def systemctl(self, *args: str) -> List[str]:
+        return [ _python, _systemctl_py, "--root=" + self.root ] + list(args)
+    def run(self, *args: str) -> int:
+        cmd = self.systemctl(*args)
+        logg.debug("run %s", " ".join(cmd))
+        return subprocess.call(cmd, stdout = subprocess.DEVNULL, stderr = subprocess.DEVNULL)
+    def timed(self, func: Callable[[], Any], rounds: Optional[int] = None) -> List[float]:
+        seconds = []
+        for _ in range(rounds or self.rounds):
+            started = time.monotonic()
+            func()
+            seconds.append(time.monotonic() - started)
+        return seconds
+    def imported(self) -> Any:
+        """ the systemctl.py module with its _root and /proc pointing to the bench tree """
+        if self.module is None:
+            module = load_systemctl(_systemctl_py)
+            module._init = False # set by its main() otherwise
+            module._root = self.root
+            module._proc_pid_dir = self.procdir
+            module._proc_pid_stat = os.path.join(self.procdir, "{pid}", "stat")
+            module._proc_pid_cmdline = os.path.join(self.procdir, "{pid}", "cmdline")
+            self.module = module
+        return self.module
+    def bench_1010_is_active_cold(self) -> BenchResult:
+        """ a new systemctl.py process for one unit among many units """
+        unit = self.names[len(self.names) // 2]
+        seconds = self.timed(lambda: self.run("is-active", unit))
+        return BenchResult("is-active", self.units, seconds)
+    def bench_1020_list_units_cold(self) -> BenchResult:
+        """ a new systemctl.py process that loads all the units """
+        seconds = self.timed(lambda: self.run("list-units", "--all"))
+        return BenchResult("list-units", self.units, seconds)
+    def bench_2010_sortedAfter(self) -> BenchResult:
+        """ the start order of all units, parsed from a new Systemctl object """
+        module = self.imported()
+        seconds = self.timed(lambda: module.Systemctl().sortedAfter(self.names))
+        return BenchResult("sortedAfter", self.units, seconds)
+    def bench_2020_pidlist_of(self) -> BenchResult:
+        """ the descendants of pid 1 in the fake /proc, from a new snapshot """
+        module = self.imported()
+        systemctl = module.Systemctl()
+        def pidlist() -> None:
+            pids = systemctl.pidlist_of(1)
+            assert len(pids) == self.procs, "%i pids" % len(pids)
+        seconds = self.timed(pidlist)
+        return BenchResult("pidlist_of", self.procs, seconds)
+    def bench_2030_system_reap_zombies(self, children: int = 50) -> BenchResult:
+        """ reaping some exited children and counting the procs left in the fake /proc """
+        module = self.imported()
+        systemctl = module.Systemctl()
+        seconds = []
+        for _ in range(self.rounds):
+            for _ in range(children):
+                if not os.fork():
+                    os._exit(0)
+            time.sleep(0.1) # let them all become zombies
+            started = time.monotonic()
+            systemctl.system_reap_zombies()
+            seconds.append(time.monotonic() - started)
+        return BenchResult("system_reap_zombies", self.procs, seconds)
+    def bench_2040_log_forwarding(self) -> BenchResult:
+        """ lines per second from a journal log to stdout (written to /dev/null) """
+        module = self.imported()
+        systemctl = module.Systemctl()
+        unit = self.names[0]
+        conf = systemctl.load_unit_conf(unit)
+        log_file = systemctl.get_journal_log_from(conf)
+        line = "bench log forwarding %s\n" % ("." * 50)
+        seconds = []
+        devnull = os.open(os.devnull, os.O_WRONLY)
+        stdout = os.dup(1)
+        try:
+            for _ in range(self.rounds):
+                if os.path.exists(log_file):
+                    os.remove(log_file)
+                text_file(log_file, line * LOGLINES)
+                systemctl.start_log_files([ unit ])
+                os.dup2(devnull, 1)
+                try:
+                    started = time.monotonic()
+                    systemctl.read_log_files([ unit ])
+                    seconds.append(time.monotonic() - started)
+                finally:
+                    os.dup2(stdout, 1)
+                systemctl.stop_log_files([ unit ])
+        finally:
+            os.close(stdout)
+            os.close(devnull)
+        return BenchResult("log-forwarding", LOGLINES, seconds, "lines/s", LOGLINES)
+    def start_stop(self, name: str, service: str) -> List[float]:
+        text_file(os_path(self.root, "/etc/systemd/system/" + name), service)
+        seconds = []
+        try:
+            for _ in range(self.rounds):
+                started = time.monotonic()
+                if self.run("start", name):
+                    logg.error("could not start %s", name)
+                if self.run("stop", name):
+                    logg.error("could not stop %s", name)
+                seconds.append(time.monotonic() - started)
+        finally:
+            os.remove(os_path(self.root, "/etc/systemd/system/" + name))
+        return seconds
+    def bench_3010_notify_start_stop(self) -> BenchResult:
+        """ a start/stop cycle of a Type=notify service that is ready at once """
+        notify = os_path(self.root, "/usr/bin/zz-notify")
+        exec_file(notify, "#! %s\nimport os, socket\n"
+            "sock = socket.socket(socket.AF_UNIX, socket.SOCK_DGRAM)\n"
+            "sock.sendto(b'READY=1\\nMAINPID=%%i' %% os.getpid(), os.environ['NOTIFY_SOCKET'])\n"
+            "os.execv('%s', [ 'sleep', '999' ])\n" % (_python, _bin_sleep))
+        seconds = self.start_stop("zznotify.service",
+            "[Service]\nType=notify\nExecStart=%s\n" % notify)
+        return BenchResult("notify-start-stop", 1, seconds)
+    def bench_3020_forking_start_stop(self) -> BenchResult:
+        """ a start/stop cycle of a Type=forking service with a PIDFile """
+        forking = os_path(self.root, "/usr/bin/zz-forking")
+        pidfile = "/var/run/zzforking.pid" # PIDFile is below the --root
+        if not os.path.isdir(os_path(self.root, "/var/run")):
+            os.makedirs(os_path(self.root, "/var/run"))
+        exec_file(forking, "#! /bin/sh\n%s 999 > /dev/null 2>&1 &\necho $! > %s\n" % (_bin_sleep, os_path(self.root, pidfile)))
+        seconds = self.start_stop("zzforking.service",
+            "[Service]\nType=forking\nPIDFile=%s\nExecStart=%s\n" % (pidfile, forking))
+        return BenchResult("forking-start-stop", 1, seconds)
+
+def previous_results(filename: str) -> Dict[Tuple[str, str], str]:
+    """ the last recorded line for each (name, size) """
+    results: Dict[Tuple[str, str], str] = {}
+    if os.path.exists(filename):
+        for line in open(filename):
+            fields = line.split()
+            if len(fields) >= 8:
+                results[(fields[3], fields[4])] = line.strip()
+    return results
+def compare(result: BenchResult, previous: Optional[str]) -> str:
+    if not previous:
+        return ""
+    fields = previous.split()
+    try:
+        old = float(fields[6])
+    except ValueError:
+        return ""
+    new = result.value(result.middle())
+    if not old or not new:
+        return ""
+    ratio = new / old
+    if result.unit == "s":
+        ratio = old / new # higher is better in both cases
+    return " (%.2fx of %s %s %s)" % (ratio, fields[1], fields[2], fields[0])
+
+if __name__ == "__main__":
+    from optparse import OptionParser
+    _o = OptionParser("%prog [options] bench*",
+       epilog=__doc__.strip().split("\n")[0])
+    _o.add_option("-v","--verbose", action="count", default=0,
+       help="increase logging level [%default]")
+    _o.add_option("--with", metavar="FILE", dest="systemctl_py", default=_systemctl_py,
+       help="systemctl.py file to be measured (%default)")
+    _o.add_option("-p","--python", metavar="EXE", default=_python,
+       help="use another python execution engine [%default]")
+    _o.add_option("-n","--units", metavar="N", type="int", default=UNITS,
+       help="synthetic units in the --root tree [%default]")
+    _o.add_option("-m","--procs", metavar="M", type="int", default=PROCS,
+       help="synthetic processes in the fake /proc tree [%default]")
+    _o.add_option("-r","--rounds", metavar="R", type="int", default=ROUNDS,
+       help="repeat each benchmark [%default]")
+    _o.add_option("-o","--output", metavar="FILE", default=_output,
+       help="append the results to compare with older runs [%default]")
+    _o.add_option("--keep", action="count", default=KEEP,
+       help="keep the generated tree in " + _benchdir)
+    opt, args = _o.parse_args()
+    logging.basicConfig(level = logging.WARNING - opt.verbose * 5)
+    KEEP = opt.keep
+    _systemctl_py = opt.systemctl_py
+    _python = opt.python
+    #
+    bench = SystemctlBench(opt.rounds, opt.units, opt.procs)
+    selected = []
+    if not args: args = [ "bench_*" ]
+    for arg in args:
+        if "*" not in arg: arg += "*"
+        if arg.startswith("_"): arg = arg[1:]
+        for method in sorted(dir(bench)):
+            if fnmatch(method, arg) and method not in selected:
+                selected.append(method)
+    if not selected:
+        logg.error("no such benchmark: %s", " ".join(args))
+        sys.exit(1)
+    previous = previous_results(opt.output)
+    stamp = datetime.datetime.now().strftime("%Y-%m-%d.%H:%M")
+    bench.setup()
+    lines = []
+    try:
+        for method in selected:
+            result = getattr(bench, method)()
+            line = result.line(stamp)
+            print(line + compare(result, previous.get((result.name, str(result.size)))))
+            lines.append(line)
+    finally:
+        bench.teardown()
+    if opt.output:
+        f = open(opt.output, "a")
+        for line in lines:
+            f.write(line + "\n")
+        f.close()
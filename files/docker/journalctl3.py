@@ -8,6 +8,8 @@ parser = argparse.ArgumentParser()
 parser.add_argument('-u', '--unit', metavar='unit', type=str, required=True, help='Systemd unit to display')
 parser.add_argument('-f', '--follow', default=False, action='store_true', help='Follows the log')
 parser.add_argument('-n', '--lines', metavar='num', type=int, help='Num of lines to display')
+parser.add_argument('--since', metavar='time', type=str, help='Show entries written since the time')
+parser.add_argument('--until', metavar='time', type=str, help='Show entries written until the time')
 parser.add_argument('--no-pager', default=False, action='store_true', help='Do not pipe through a pager')
 parser.add_argument('--system', default=False, action='store_true', help='Show system units')
 parser.add_argument('--user', default=False, action='store_true', help='Show user units')
@@ -22,10 +24,12 @@ systemctl = os.path.join(path, systemctl_py)
 cmd = [ systemctl, "log", args.unit ] # drops the -u
 if args.follow: cmd += [ "-f" ]
 if args.lines: cmd += [ "-n", str(args.lines) ]
+if args.since: cmd += [ "--since", args.since ]
+if args.until: cmd += [ "--until", args.until ]
 if args.no_pager: cmd += [ "--no-pager" ]
 if args.system: cmd += [ "--system" ]
 elif args.user: cmd += [ "--user" ]
-if args.root: cmd += [ "--root", start(args.root) ]
+if args.root: cmd += [ "--root", args.root ]
 if args.x: cmd += [ "-vvv" ]
 
 os.execvp(cmd[0], cmd)
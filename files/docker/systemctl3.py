@@ -23,11 +23,17 @@ import socket
 import datetime
 import string
 import fcntl
+import stat
 import select
+import struct
+import heapq
 import hashlib
+import json
 import pwd
 import grp
+import resource
 import threading
+import copy
 
 if sys.version[0] == '3':
     basestring = str
@@ -60,6 +66,8 @@ _force = False
 _full = False
 _log_lines = 0
 _no_pager = False
+_log_since = None
+_log_until = None
 _now = False
 _no_reload = False
 _no_legend = False
@@ -67,6 +75,7 @@ _no_ask_password = False
 _preset_mode = "all"
 _quiet = False
 _root = ""
+_timings = False
 _unit_type = None
 _unit_state = None
 _unit_property = None
@@ -119,6 +128,9 @@ _proc_pid_cmdline= "/proc/{pid}/cmdline"
 _proc_pid_dir    = "/proc"
 _proc_sys_uptime = "/proc/uptime"
 _proc_sys_stat   = "/proc/stat"
+_proc_self_cgroup = "/proc/self/cgroup"
+_proc_self_oom_score_adj = "/proc/self/oom_score_adj"
+_cgroup_folder   = "/sys/fs/cgroup" # the cgroup2 mount (CGROUP_TRACKING)
 
 # default values
 SystemCompatibilityVersion = 219
@@ -135,6 +147,15 @@ DefaultRestartSec = 0.1       # official value of 100ms
 DefaultStartLimitIntervalSec = 10 # official value
 DefaultStartLimitBurst = 5        # official value
 InitLoopSleep = 5
+ReapedStatusSec = 60 # forget an exit status reaped by the init-loop that nobody asked for
+LogForwardPollSec = 0.1 # when there is no inotify for the journal logs
+JournalLogMaxSize = 10485760 # rotate a journal log written by PID-1 (JOURNAL_PIPES)
+JournalIndexSec = 10 # timestamp->offset entries in a journal index (for --since)
+ControlTimeoutSec = 10 # a control socket client runs a read-only command itself without a reply by then
+MaxParallelJobs = 1 # start/stop independent units concurrently (opt-in, 1 is sequential)
+InitStopParallelJobs = 4 # stop independent units concurrently at the end of the init-loop
+MetricsIntervalSec = 5.0 # the init-loop rewrites the metrics textfile at most that often
+ChownParallelJobs = 4 # threads that walk a large service directory for its chown
 MaxLockWait = 0 # equals DefaultMaximumTimeout
 DefaultPath = "/usr/local/sbin:/usr/local/bin:/usr/sbin:/usr/bin:/sbin:/bin"
 ResetLocale = ["LANG", "LANGUAGE", "LC_CTYPE", "LC_NUMERIC", "LC_TIME", "LC_COLLATE", "LC_MONETARY",
@@ -142,6 +163,7 @@ ResetLocale = ["LANG", "LANGUAGE", "LC_CTYPE", "LC_NUMERIC", "LC_TIME", "LC_COLL
                "LC_IDENTIFICATION", "LC_ALL"]
 LocaleConf="/etc/locale.conf"
 DefaultListenBacklog=2
+DefaultMaxConnections=64 # official value
 
 ExitWhenNoMoreServices = False
 ExitWhenNoMoreProcs = False
@@ -157,6 +179,7 @@ DefaultStandardError=os.environ.get("SYSTEMD_STANDARD_ERROR", "inherit") # syste
 
 EXEC_SPAWN = False
 EXEC_DUP2 = True
+EXEC_POSIX_SPAWN = True # run the exec commands via os.posix_spawn when no python code is needed in the child
 REMOVE_LOCK_FILE = False
 BOOT_PID_MIN = 0
 BOOT_PID_MAX = -9
@@ -164,7 +187,21 @@ PROC_MAX_DEPTH = 100
 EXPAND_VARS_MAXDEPTH = 20
 EXPAND_KEEP_VARS = True
 RESTART_FAILED_UNITS = True
+INIT_LOOP_EVENTS = True # wake on SIGCHLD and timers instead of sleep ticks
 ACTIVE_IF_ENABLED=False
+UNIT_FILE_CACHE = True # use the parsed unit files from the last daemon-reload
+INOTIFY = True # use inotify(7) when waiting for files to appear or change
+LOG_FORWARDER = True # forward the journal logs in a thread instead of init-loop ticks
+LOG_READER = True # systemctl log reads the journal logs itself instead of tail/cat
+JOURNAL_PIPES = False # in init mode services write to a fifo that PID-1 tees to stdout and the log
+CONTROL_SOCKET = True # in init mode PID-1 runs the ControlCommands of other systemctl calls
+CGROUP_TRACKING = False # in init mode each service runs in its own cgroup (on a writable cgroup2)
+METRICS_TEXTFILE = False # in init mode PID-1 rewrites a textfile of prometheus metrics
+
+ReadOnlyCommands = [ "is-active", "is-failed", "is-enabled", "is-system-running", "status", "show",
+    "cat", "list-units", "list-unit-files", "list-dependencies", "log", "get-default", "environment", "analyze" ]
+ControlCommands = [ "start", "stop", "restart", "reload", "try-restart", "reload-or-restart", "reload-or-try-restart",
+    "is-active", "is-failed", "is-system-running", "status", "show" ]
 
 TAIL_CMD = "/usr/bin/tail"
 LESS_CMD = "/usr/bin/less"
@@ -172,7 +209,14 @@ CAT_CMD = "/usr/bin/cat"
 
 # The systemd default was NOTIFY_SOCKET="/var/run/systemd/notify"
 _notify_socket_folder = "{RUN}/systemd" # alias /run/systemd
+_unit_file_cache = "{RUN}/systemd/systemctl.units.cache" # written by daemon-reload
+_boottime_cache = "{RUN}/systemctl.boottime.cache" # valid while PID-1 is running
 _journal_log_folder = "{LOG}/journal"
+_journal_pipe_folder = "{RUN}/journal" # fifos to PID-1 (JOURNAL_PIPES)
+_control_socket_file = "{RUN}/systemd/systemctl.private" # served by PID-1 (CONTROL_SOCKET)
+_cgroup_base_file = "{RUN}/systemctl.cgroup" # the cgroup of the units while PID-1 is running
+_metrics_textfile = "{RUN}/systemd/systemctl.prom" # written by PID-1 (METRICS_TEXTFILE)
+_metrics_start_buckets = [ 0.1, 0.5, 1, 2.5, 5, 10, 30, 60 ] # seconds of a unit start
 
 SYSTEMCTL_DEBUG_LOG = "{LOG}/systemctl.debug.log"
 SYSTEMCTL_EXTRA_LOG = "{LOG}/systemctl.log"
@@ -256,6 +300,27 @@ def to_list(value):
 def int_mode(value):
     try: return int(value, 8)
     except: return None # pragma: no cover
+def thread_map(func, items, jobs):
+    """ like map() but the items are done by some threads (for calls that release the GIL) """
+    results = [ None ] * len(items)
+    if jobs <= 1 or len(items) <= 1:
+        return [ func(item) for item in items ]
+    position = [ 0 ]
+    lock = threading.Lock()
+    def worker():
+        while True:
+            with lock:
+                index = position[0]
+                position[0] += 1
+            if index >= len(items):
+                return
+            results[index] = func(items[index])
+    threads = [ threading.Thread(target=worker) for _ in xrange(min(jobs, len(items))) ]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    return results
 def unit_of(module):
     if "." not in module:
         return module + ".service"
@@ -305,6 +370,18 @@ def path_replace_extension(path, old, new):
         path = path[:-len(old)]
     return path + new
 
+def json_str_hook(data):
+    """ python2 json.load returns unicode strings """
+    if sys.version[0] == '3':
+        return data
+    def str_of(value):
+        if isinstance(value, unicode): # pragma: no cover (python2)
+            return value.encode("utf-8")
+        if isinstance(value, list):
+            return [ str_of(item) for item in value ]
+        return value
+    return dict([ (str_of(key), str_of(value)) for key, value in data.items() ])
+
 def get_PAGER():
     PAGER = os.environ.get("PAGER", "less")
     pager = os.environ.get("SYSTEMD_PAGER", "{PAGER}").format(**locals())
@@ -492,6 +569,9 @@ def shutil_truncate(filename):
     f = open(filename, "w")
     f.write("")
     f.close()
+def path_temp_name(filename):
+    """ a temp name next to the file before os.rename - unique per process and thread """
+    return "%s.%s.%s.tmp" % (filename, os.getpid(), threading.current_thread().ident)
 
 # http://stackoverflow.com/questions/568271/how-to-check-if-there-exists-a-process-with-a-given-pid
 def pid_exists(pid):
@@ -552,6 +632,195 @@ def _pid_zombie(pid):
         return False
     return False
 
+def pid_open(pid):
+    """ a pidfd that gets readable when the process has exited (or None on older systems) """
+    if not hasattr(os, "pidfd_open") or not pid:
+        return None
+    try:
+        return os.pidfd_open(int(pid))
+    except OSError as e:
+        logg.debug("pidfd_open %s: %s", pid, e)
+        return None
+
+def get_errno():
+    import ctypes
+    return ctypes.get_errno()
+
+IN_MODIFY = 0x00000002
+IN_CLOSE_WRITE = 0x00000008
+IN_MOVED_TO = 0x00000080
+IN_CREATE = 0x00000100
+
+class InotifyWatch:
+    """ a minimal ctypes binding of inotify(7) - it is only used to wake up
+        when something has changed in the watched folders or files. """
+    def __init__(self, libc, fd):
+        self.libc = libc
+        self.fd = fd
+    def add(self, path, mask = IN_CREATE | IN_MOVED_TO | IN_CLOSE_WRITE | IN_MODIFY):
+        if not isinstance(path, bytes):
+            path = path.encode("utf-8")
+        wd = self.libc.inotify_add_watch(self.fd, path, mask)
+        if wd < 0:
+            logg.debug("inotify_add_watch %s: errno %s", path, get_errno())
+            return False
+        return True
+    def wait(self, timeout):
+        """ returns True when there were events within the timeout (they are drained) """
+        try:
+            readable, _, _ = select.select([self.fd], [], [], max(0, timeout))
+        except (select.error, OSError) as e:
+            if e.args and e.args[0] == errno.EINTR:
+                return False
+            raise
+        if not readable:
+            return False
+        self.drain()
+        return True
+    def drain(self):
+        try:
+            while os.read(self.fd, 4096):
+                pass
+        except OSError as e:
+            if e.errno not in [ errno.EAGAIN, errno.EWOULDBLOCK ]:
+                raise
+    def close(self):
+        os.close(self.fd)
+
+def inotify_watch():
+    """ an InotifyWatch - or None when inotify is not available """
+    if not INOTIFY:
+        return None
+    try:
+        import ctypes
+        libc = ctypes.CDLL(None, use_errno=True)
+        fd = libc.inotify_init1(0o4000 | 0o2000000) # IN_NONBLOCK | IN_CLOEXEC
+    except (ImportError, OSError, AttributeError) as e:
+        logg.debug("no inotify: %s", e)
+        return None
+    if fd < 0:
+        logg.debug("no inotify: errno %s", get_errno())
+        return None
+    return InotifyWatch(libc, fd)
+
+IOPRIO_CLASSES = { "none": 0, "realtime": 1, "best-effort": 2, "idle": 3 }
+IOPRIO_SYSCALLS = { "x86_64": 251, "i686": 289, "aarch64": 30, "armv7l": 314, "ppc64le": 273, "s390x": 282 }
+
+def ioprio_set(ioclass, level):
+    """ set the io scheduling of the current process (there is no python binding) """
+    number = IOPRIO_SYSCALLS.get(os.uname()[4])
+    if not number:
+        logg.debug("no ioprio_set on %s", os.uname()[4])
+        return False
+    try:
+        import ctypes
+        libc = ctypes.CDLL(None, use_errno=True)
+        done = libc.syscall(number, 1, 0, (ioclass << 13) | level) # IOPRIO_WHO_PROCESS self
+    except (ImportError, OSError, AttributeError) as e:
+        logg.debug("no ioprio_set: %s", e)
+        return False
+    if done < 0:
+        logg.debug("ioprio_set: errno %s", get_errno())
+        return False
+    return True
+
+proc_result = collections.namedtuple("ProcEntry", ["pid", "ppid", "state", "starttime"])
+
+class ProcTable:
+    """ a snapshot of the process table - it is a single pass over /proc where the
+        /proc/<pid>/stat is read once for each pid and the cmdline only on request,
+        so that pidlist_of, killall and the reaper do not need to rescan /proc. """
+    def __init__(self):
+        self._pids = []
+        for pid_entry in os.listdir(_proc_pid_dir):
+            pid = to_intN(pid_entry)
+            if pid is not None:
+                self._pids.append(pid)
+        self._pidset = set(self._pids)
+        self._entries = None # pid => proc_result
+        self._children = None # ppid => [ pid, ...]
+        self._cmdline = {}
+    def pids(self):
+        return self._pids
+    def entries(self):
+        if self._entries is None:
+            self._entries = {}
+            for pid in self._pids:
+                entry = self.read_entry(pid)
+                if entry:
+                    self._entries[pid] = entry
+        return self._entries
+    def read_entry(self, pid):
+        proc_stat = _proc_pid_stat.format(**locals())
+        try:
+            f = open(proc_stat)
+            text = f.read()
+            f.close()
+        except (IOError, OSError):
+            return None # process has gone
+        # "pid (comm) state ppid pgrp session tty tpgid flags minflt cminflt majflt cmajflt utime stime cutime cstime priority nice threads itrealvalue starttime ..."
+        comm_end = text.rfind(")")
+        fields = text[comm_end+2:].split()
+        if len(fields) < 20:
+            return None
+        return proc_result(pid, to_int(fields[1]), fields[0], to_int(fields[19]))
+    def entry(self, pid):
+        return self.entries().get(pid)
+    def exists(self, pid):
+        return pid in self.entries()
+    def zombie(self, pid):
+        entry = self.entry(pid)
+        return entry is not None and entry.state == "Z"
+    def alive(self, pid):
+        """ exists and not a zombie - it reads only the stat of that pid """
+        if self._entries is not None:
+            entry = self._entries.get(pid)
+        elif pid in self._pidset:
+            entry = self.read_entry(pid)
+        else:
+            return False
+        return entry is not None and entry.state != "Z"
+    def children(self, pid):
+        if self._children is None:
+            self._children = {}
+            for entry in self.entries().values():
+                self._children.setdefault(entry.ppid, []).append(entry.pid)
+            for pids in self._children.values():
+                pids.sort()
+        return self._children.get(pid, [])
+    def descendants(self, pid):
+        """ the pid and all its children, grand-children (up to PROC_MAX_DEPTH) """
+        pids = [ pid ]
+        seen = set(pids)
+        generation = [ pid ]
+        for depth in xrange(PROC_MAX_DEPTH):
+            found = []
+            for ppid in generation:
+                for child in self.children(ppid):
+                    if child not in seen:
+                        seen.add(child)
+                        found.append(child)
+            if not found:
+                break
+            pids += found
+            generation = found
+        return pids
+    def cmdline(self, pid):
+        if pid not in self._cmdline:
+            proc_cmdline = _proc_pid_cmdline.format(**locals())
+            f = open(proc_cmdline)
+            self._cmdline[pid] = f.read().split("\0")
+            f.close()
+        return self._cmdline[pid]
+
+_env_file_single_quoted = re.compile(r"(?:export +)?([\w_]+)[=]'([^']*)'")
+_env_file_double_quoted = re.compile(r'(?:export +)?([\w_]+)[=]"([^"]*)"')
+_env_file_unquoted = re.compile(r'(?:export +)?([\w_]+)[=](.*)')
+_env_part_assignment = re.compile(r'\s*("[\w_]+=[^"]*"|[\w_]+=\S*)')
+_expand_env_var = re.compile(r"[$](\w+)")
+_expand_env_braced = re.compile(r"[$][{](\w+)[}]")
+_expand_special_var = re.compile(r"[%](.)")
+
 def checkstatus(cmd):
     if cmd.startswith("-"):
         return False, cmd[1:]
@@ -771,6 +1040,8 @@ class SystemctlSocket:
         self.conf = conf
         self.sock = sock
         self.skip = skip
+        self.accepted = 0 # Accept=yes connection number
+        self.connections = {} # Accept=yes instance unit -> (source, conf)
     def fileno(self):
         return self.sock.fileno()
     def listen(self, backlog = None):
@@ -788,6 +1059,18 @@ class SystemctlSocket:
     def close(self):
         self.sock.close()
 
+def socket_connection_names(conn, addr, nr):
+    """ the (source, instance) of an accepted connection - the instance name
+        is like in systemd, that is 'nr-pid-uid' or 'nr-local:port-remote:port'
+        and the source is used for MaxConnectionsPerSource """
+    if conn.family == socket.AF_UNIX:
+        SO_PEERCRED = getattr(socket, "SO_PEERCRED", 17)
+        creds = conn.getsockopt(socket.SOL_SOCKET, SO_PEERCRED, struct.calcsize("3i"))
+        pid, uid, gid = struct.unpack("3i", creds)
+        return "uid:%i" % uid, "%i-%i-%i" % (nr, pid, uid)
+    local = conn.getsockname()
+    return addr[0], "%i-%s:%s-%s:%s" % (nr, local[0], local[1], addr[0], addr[1])
+
 class SystemctlConf:
     def __init__(self, data, module = None):
         self.data = data # UnitConfParser
@@ -862,6 +1145,11 @@ class PresetFile:
         return None
 
 ## with waitlock(conf): self.start()
+class WaitLockTimeout(Exception):
+    pass
+def waitlock_alarm(signum, frame):
+    raise WaitLockTimeout()
+
 class waitlock:
     def __init__(self, conf):
         self.conf = conf # currently unused
@@ -886,7 +1174,7 @@ class waitlock:
             for attempt in xrange(int(MaxLockWait or DefaultMaximumTimeout)):
                 try:
                     logg_debug_flock("[%s] %s. trying %s _______ ", os.getpid(), attempt, lockname)
-                    fcntl.flock(self.opened, fcntl.LOCK_EX | fcntl.LOCK_NB)
+                    self.flock(attempt and 1 or 0) # until MaxLockWait
                     st = os.fstat(self.opened)
                     if not st.st_nlink:
                         logg_debug_flock("[%s] %s. %s got deleted, trying again", os.getpid(), attempt, lockname)
@@ -901,13 +1189,44 @@ class waitlock:
                     whom = os.read(self.opened, 4096)
                     os.lseek(self.opened, 0, os.SEEK_SET)
                     logg.info("[%s] %s. systemctl locked by %s", os.getpid(), attempt, whom.rstrip())
-                    time.sleep(1) # until MaxLockWait
                     continue
             logg.error("[%s] not able to get the lock to %s", os.getpid(), lockname)
         except Exception as e:
             logg.warning("[%s] oops %s, %s", os.getpid(), str(type(e)), e)
         #TODO# raise Exception("no lock for %s", self.unit or "global")
         return False
+    def flock(self, timeout):
+        """ a blocking flock for upto timeout seconds (else IOError) - it is interrupted by
+            an interval timer where possible (the signal needs the main thread), otherwise
+            it is polling with a backoff. The lock is taken as soon as it was released. """
+        try:
+            fcntl.flock(self.opened, fcntl.LOCK_EX | fcntl.LOCK_NB)
+            return
+        except IOError:
+            if timeout <= 0:
+                raise
+        if hasattr(signal, "setitimer") and threading.current_thread().name == "MainThread":
+            handler = signal.signal(signal.SIGALRM, waitlock_alarm)
+            try:
+                signal.setitimer(signal.ITIMER_REAL, timeout)
+                fcntl.flock(self.opened, fcntl.LOCK_EX)
+                return
+            except WaitLockTimeout:
+                raise IOError(errno.EAGAIN, "lock wait timeout")
+            finally:
+                signal.setitimer(signal.ITIMER_REAL, 0)
+                signal.signal(signal.SIGALRM, handler is None and signal.SIG_DFL or handler)
+        deadline = time.time() + timeout
+        backoff = 0.01 # seconds, doubled up to 0.5
+        while True:
+            time.sleep(max(0, min(backoff, deadline - time.time())))
+            try:
+                fcntl.flock(self.opened, fcntl.LOCK_EX | fcntl.LOCK_NB)
+                return
+            except IOError:
+                if time.time() >= deadline:
+                    raise
+            backoff = min(backoff * 2, 0.5)
     def __exit__(self, type, value, traceback):
         try:
             os.lseek(self.opened, 0, os.SEEK_SET)
@@ -923,6 +1242,21 @@ class waitlock:
         except Exception as e:
             logg.warning("oops, %s", e)
 
+class batchstates:
+    """ while checking the states of many units (list-units, status) there is one
+        snapshot of /proc and one listing of each status folder for all of them """
+    def __init__(self, systemctl):
+        self.systemctl = systemctl
+        self.saved = (None, None)
+    def __enter__(self):
+        self.saved = (self.systemctl._proc_snapshot, self.systemctl._status_folders)
+        if self.systemctl._proc_snapshot is None:
+            self.systemctl._proc_snapshot = ProcTable()
+            self.systemctl._status_folders = {}
+        return self
+    def __exit__(self, type, value, traceback):
+        self.systemctl._proc_snapshot, self.systemctl._status_folders = self.saved
+
 waitpid_result = collections.namedtuple("waitpid", ["pid", "returncode", "signal" ])
 
 def must_have_failed(waitpid, cmd):
@@ -942,11 +1276,37 @@ def must_have_failed(waitpid, cmd):
             waitpid = waitpid_result(waitpid.pid, 11, waitpid.signal)
     return waitpid
 
+_reaped_status = {} # pid => (status, time) of the children collected by the init-loop
+_reaped_lock = threading.Lock() # (see reap_zombie and reaped_waitpid)
+
+def reap_zombie():
+    """ waitpid for any child - the exit status is kept for a thread that is
+        waiting for that pid itself (e.g. a start from the control thread) """
+    with _reaped_lock:
+        pid, status = os.waitpid(-1, os.WNOHANG)
+        if pid:
+            now = time.time()
+            for old in [ old for old, (_, when) in _reaped_status.items() if when < now - ReapedStatusSec ]:
+                del _reaped_status[old]
+            _reaped_status[pid] = (status, now)
+    return pid, status
+def reaped_waitpid(pid, options):
+    """ os.waitpid - or the exit status that the init-loop has reaped already """
+    try:
+        return os.waitpid(pid, options)
+    except OSError as e:
+        if e.errno != errno.ECHILD:
+            raise
+        with _reaped_lock:
+            if pid not in _reaped_status:
+                raise
+            status, _ = _reaped_status.pop(pid)
+        return pid, status
 def subprocess_waitpid(pid):
-    run_pid, run_stat = os.waitpid(pid, 0)
+    run_pid, run_stat = reaped_waitpid(pid, 0)
     return waitpid_result(run_pid, os.WEXITSTATUS(run_stat), os.WTERMSIG(run_stat))
 def subprocess_testpid(pid):
-    run_pid, run_stat = os.waitpid(pid, os.WNOHANG)
+    run_pid, run_stat = reaped_waitpid(pid, os.WNOHANG)
     if run_pid:
         return waitpid_result(run_pid, os.WEXITSTATUS(run_stat), os.WTERMSIG(run_stat))
     else:
@@ -971,6 +1331,18 @@ def parse_unit(fullname): # -> object(prefix, instance, suffix, ...., name, comp
         component = prefix[has_component+1:]
     return parse_result(fullname, name, prefix, instance, suffix, component)
 
+def size_to_bytes(text): # -> int?
+    """ the systemd sizes like '512M' use a base of 1024 """
+    text = text.strip()
+    factors = { "K": 1024, "M": 1024**2, "G": 1024**3, "T": 1024**4 }
+    factor = factors.get(text[-1:].upper(), 1)
+    if factor > 1:
+        text = text[:-1]
+    try:
+        return int(float(text) * factor)
+    except ValueError:
+        return None
+
 def time_to_seconds(text, maximum):
     value = 0.
     for part in str(text).split(" "):
@@ -1014,9 +1386,139 @@ def seconds_to_time(seconds):
         return "%smin %sms" % (mins, msecs)
     elif mins:
         return "%smin" % (mins)
+    elif msecs and not secs:
+        return "%sms" % (msecs)
     else:
         return "%ss" % (secs)
 
+def monotonic_usec():
+    """ microseconds of the CLOCK_MONOTONIC - the same in all processes (see --timings) """
+    if hasattr(time, "monotonic"):
+        return int(time.monotonic() * 1000000)
+    with open(_proc_sys_uptime) as f: # python2
+        return int(float(f.read().split()[0]) * 1000000)
+def usec_to_time(usec):
+    """ the durations of analyze blame """
+    if usec >= 1000000:
+        return "%.3fs" % (usec / 1000000.)
+    return "%sms" % (int(usec) // 1000)
+def timing_span(timings, begin, end):
+    """ usec between two Timing* phases of a status file (or None) """
+    began = to_intN(timings.get("Timing" + begin))
+    ended = to_intN(timings.get("Timing" + end))
+    if began is None or ended is None:
+        return None
+    return max(0, ended - began)
+
+_journal_time_span = re.compile(r"(\d+)\s*([a-z]*)")
+_journal_time_units = { "": 1, "s": 1, "sec": 1, "second": 1, "seconds": 1,
+    "m": 60, "min": 60, "minute": 60, "minutes": 60, "h": 3600, "hour": 3600, "hours": 3600,
+    "d": 86400, "day": 86400, "days": 86400, "w": 604800, "week": 604800, "weeks": 604800 }
+_journal_time_formats = [ "%Y-%m-%d %H:%M:%S", "%Y-%m-%d %H:%M", "%Y-%m-%d", "%H:%M:%S", "%H:%M" ]
+def journal_time(text, now = None):
+    """ the timestamp for --since/--until - 'YYYY-MM-DD [HH:MM[:SS]]', 'HH:MM[:SS]',
+        '@epoch', 'now', 'today', 'yesterday', 'tomorrow', '5 min ago', '-5min', '+1h' """
+    if now is None:
+        now = time.time()
+    item = text.strip().lower()
+    year, month, day = time.localtime(now)[:3]
+    days = { "today": 0, "yesterday": -1, "tomorrow": 1 }
+    if item == "now":
+        return now
+    if item in days:
+        return time.mktime((year, month, day + days[item], 0, 0, 0, 0, 0, -1))
+    if item.startswith("@"):
+        try: return float(item[1:])
+        except ValueError: return None
+    sign = 0
+    if item.endswith(" ago"):
+        sign, item = -1, item[:-len(" ago")]
+    elif item[:1] in "-+" and item[1:2].isdigit():
+        sign, item = (item[0] == "-") and -1 or 1, item[1:]
+    if sign:
+        seconds = 0
+        for value, unit in _journal_time_span.findall(item):
+            if unit not in _journal_time_units:
+                return None
+            seconds += int(value) * _journal_time_units[unit]
+        return now + sign * seconds
+    for timeformat in _journal_time_formats:
+        try:
+            parsed = time.strptime(item, timeformat)
+        except ValueError:
+            continue
+        if not timeformat.startswith("%Y"):
+            parsed = (year, month, day) + tuple(parsed[3:6])
+        return time.mktime(tuple(parsed[:6]) + (0, 0, -1))
+    return None
+def journal_index_range(index_file, size, since = None, until = None):
+    """ the (start, end) offsets in a journal log for the since/until timestamps,
+        using the sparse timestamp->offset entries written by the log forwarder """
+    entries = []
+    try:
+        with open(index_file) as f:
+            for line in f:
+                stamp, _, offset = line.partition(" ")
+                try:
+                    entry = (float(stamp), int(offset))
+                except ValueError:
+                    continue
+                if entries and entry[1] < entries[-1][1]:
+                    entries = [] # the log was truncated or rotated
+                if entry[1] <= size:
+                    entries.append(entry)
+    except (IOError, OSError) as e:
+        logg.debug("no journal index %s: %s", index_file, e)
+    start, end = 0, size
+    for stamp, offset in entries:
+        if since is not None and stamp <= since:
+            start = offset
+        if until is not None and stamp > until:
+            end = offset
+            break
+    return start, max(start, end)
+def journal_tail_offset(fd, start, end, lines):
+    """ the offset of the last lines before end - reading backwards in blocks """
+    BUFSIZE = 65536
+    if end <= start or lines <= 0:
+        return end
+    os.lseek(fd, end - 1, os.SEEK_SET)
+    found = lines + (os.read(fd, 1) == b"\n" and 1 or 0) # newlines to pass
+    pos = end
+    while pos > start:
+        size = min(BUFSIZE, pos - start)
+        os.lseek(fd, pos - size, os.SEEK_SET)
+        block = os.read(fd, size)
+        at = len(block)
+        while True:
+            at = block.rfind(b"\n", 0, at)
+            if at < 0: break
+            found -= 1
+            if not found:
+                return pos - size + at + 1
+        pos -= size
+    return start
+def journal_copy(fd, start, end):
+    """ copy the bytes from a journal log to stdout - False on a closed stdout """
+    BUFSIZE = 65536
+    sys.stdout.flush()
+    os.lseek(fd, start, os.SEEK_SET)
+    while start < end:
+        buf = os.read(fd, min(BUFSIZE, end - start))
+        if not buf: break
+        start += len(buf)
+        while buf:
+            try:
+                written = os.write(1, buf)
+            except OSError as e:
+                if e.errno == errno.EINTR:
+                    continue
+                if e.errno == errno.EPIPE:
+                    return False
+                raise
+            buf = buf[written:]
+    return True
+
 def getBefore(conf):
     result = []
     beforelist = conf.getlist("Unit", "Before", [])
@@ -1058,59 +1560,144 @@ def compareAfter(confA, confB):
             return -1
     return 0
 
-def conf_sortedAfter(conflist, cmp = compareAfter):
-    # the normal sorted() does only look at two items
-    # so if "A after C" and a list [A, B, C] then
-    # it will see "A = B" and "B = C" assuming that
-    # "A = C" and the list is already sorted.
-    #
-    # To make a totalsorted we have to create a marker
-    # that informs sorted() that also B has a relation.
-    # It only works when 'after' has a direction, so
-    # anything without 'before' is a 'after'. In that
-    # case we find that "B after C".
-    class SortTuple:
-        def __init__(self, rank, conf):
-            self.rank = rank
-            self.conf = conf
-    sortlist = [ SortTuple(0, conf) for conf in conflist]
-    for check in xrange(len(sortlist)): # maxrank = len(sortlist)
-        changed = 0
-        for A in xrange(len(sortlist)):
-            for B in xrange(len(sortlist)):
-                if A != B:
-                    itemA = sortlist[A]
-                    itemB = sortlist[B]
-                    before = compareAfter(itemA.conf, itemB.conf)
-                    if before > 0 and itemA.rank <= itemB.rank:
-                        logg_debug_after("  %-30s before %s", itemA.conf.name(), itemB.conf.name())
-                        itemA.rank = itemB.rank + 1
-                        changed += 1
-                    if before < 0 and itemB.rank <= itemA.rank:
-                        logg_debug_after("  %-30s before %s", itemB.conf.name(), itemA.conf.name())
-                        itemB.rank = itemA.rank + 1
-                        changed += 1
-        if not changed:
-            logg_debug_after("done in check %s of %s", check, len(sortlist))
-            break
-            # because Requires is almost always the same as the After clauses
-            # we are mostly done in round 1 as the list is in required order
-    for conf in conflist:
-        logg_debug_after(".. %s", conf.name())
-    for item in sortlist:
-        logg_debug_after("(%s) %s", item.rank, item.conf.name())
-    sortedlist = sorted(sortlist, key = lambda item: -item.rank)
-    for item in sortedlist:
-        logg_debug_after("[%s] %s", item.rank, item.conf.name())
-    return [ item.conf for item in sortedlist ]
+class SortedAfterGraph:
+    """ the After/Before ordering of a list of units where the
+        dependency lists are extracted once for each conf. An
+        edge A => B says that A has to be started before B. """
+    def __init__(self, conflist):
+        self.confs = list(conflist)
+        self.names = [ conf.name() for conf in self.confs ]
+        self.index = {} # name => [index]
+        for item, name in enumerate(self.names):
+            self.index.setdefault(name, []).append(item)
+        self.before = [ set() for conf in self.confs ]
+        self.after = [ set() for conf in self.confs ]
+        for item, conf in enumerate(self.confs):
+            for name in getAfter(conf):
+                for dep in self.index.get(name, []):
+                    self.edge(dep, item)
+            for name in getBefore(conf):
+                for dep in self.index.get(name, []):
+                    self.edge(item, dep)
+    def edge(self, first, then):
+        if first != then:
+            logg_debug_after("  %-30s before %s", self.names[first], self.names[then])
+            self.before[first].add(then)
+            self.after[then].add(first)
+    def requires(self, name):
+        """ the names in the list that must be started before """
+        found = []
+        for item in self.index.get(name, []):
+            for dep in sorted(self.after[item]):
+                if self.names[dep] not in found:
+                    found.append(self.names[dep])
+        return found
+    def ranks(self):
+        """ Kahn's algorithm from the end - the rank is the longest
+            chain of units that must be started afterwards. A loop is
+            reported and broken up at its first unit in the list. """
+        ranks = [ 0 for conf in self.confs ]
+        waiting = [ len(self.before[item]) for item in xrange(len(self.confs)) ]
+        ready = collections.deque([ item for item in xrange(len(self.confs)) if not waiting[item] ])
+        done = 0
+        while done < len(self.confs):
+            if not ready:
+                item = [ item for item in xrange(len(self.confs)) if waiting[item] > 0 ][0]
+                path = []
+                while item not in path:
+                    path.append(item)
+                    item = min([ dep for dep in self.before[item] if waiting[dep] > 0 ])
+                loop = sorted(path[path.index(item):])
+                logg.warning("dependency loop in After/Before of %s", " ".join([ self.names[item] for item in loop ]))
+                waiting[loop[0]] = 0
+                ready.append(loop[0])
+            item = ready.popleft()
+            waiting[item] = -1
+            done += 1
+            for dep in self.after[item]:
+                if waiting[dep] < 0:
+                    continue # the loop was broken up there
+                if ranks[dep] <= ranks[item]:
+                    ranks[dep] = ranks[item] + 1
+                if waiting[dep] > 0:
+                    waiting[dep] -= 1
+                    if not waiting[dep]:
+                        ready.append(dep)
+        return ranks
+    def sorted(self):
+        ranks = self.ranks()
+        for item, conf in enumerate(self.confs):
+            logg_debug_after("(%s) %s", ranks[item], conf.name())
+        # sorted() is stable, so the list order is kept for the same rank
+        sortedlist = sorted(xrange(len(self.confs)), key = lambda item: -ranks[item])
+        for item in sortedlist:
+            logg_debug_after("[%s] %s", ranks[item], self.names[item])
+        return [ self.confs[item] for item in sortedlist ]
+
+def conf_sortedAfter(conflist):
+    return SortedAfterGraph(conflist).sorted()
+
+class SystemctlLogForwarder(threading.Thread):
+    """ forwards the journal logs of the units to stdout as soon
+        as something was written (see read_log_files) """
+    def __init__(self, systemctl, units):
+        threading.Thread.__init__(self, name="logs")
+        self.systemctl = systemctl
+        self.units = units
+        self.stopping = os.pipe()
+    def stop(self):
+        os.write(self.stopping[1], b"x")
+    def run(self):
+        watch = inotify_watch()
+        fifos = []
+        for unit, log_fd in self.systemctl._log_file.items():
+            if stat.S_ISFIFO(os.fstat(log_fd).st_mode):
+                fifos.append(log_fd)
+            elif watch:
+                conf = self.systemctl.load_unit_conf(unit)
+                if conf is not None:
+                    watch.add(self.systemctl.get_journal_log_from(conf), IN_MODIFY)
+        waiting = [ self.stopping[0] ] + fifos
+        if watch:
+            waiting.append(watch.fd)
+        timeout = watch and InitLoopSleep or LogForwardPollSec # regular files are always readable
+        try:
+            while True:
+                self.systemctl.read_log_files(self.units)
+                try:
+                    readable, _, _ = select.select(waiting, [], [], timeout)
+                except (select.error, OSError) as e:
+                    if e.args and e.args[0] == errno.EINTR:
+                        continue
+                    raise
+                if self.stopping[0] in readable:
+                    break
+                if watch and watch.fd in readable:
+                    watch.drain()
+        finally:
+            if watch:
+                watch.close()
+            for fd in self.stopping:
+                os.close(fd)
 
 class SystemctlListenThread(threading.Thread):
+    """ accepts on the listening sockets as soon as they are readable - it
+        blocks in poll until then (or until stop() writes to the stopping pipe) """
     def __init__(self, systemctl):
         threading.Thread.__init__(self, name="listen")
         self.systemctl = systemctl
         self.stopped = threading.Event()
+        self.stopping = os.pipe()
     def stop(self):
         self.stopped.set()
+        try:
+            os.write(self.stopping[1], b"x")
+        except OSError as e:
+            logg.debug("listen: stopping %s", e) # the thread has closed the other end
+        os.close(self.stopping[1])
+    def readable(self, fileno):
+        readable, _, _ = select.select([fileno], [], [], 0)
+        return bool(readable)
     def run(self):
         READ_ONLY = select.POLLIN | select.POLLPRI | select.POLLHUP | select.POLLERR
         READ_WRITE = READ_ONLY | select.POLLOUT
@@ -1118,51 +1705,238 @@ class SystemctlListenThread(threading.Thread):
         if DEBUG_INITLOOP: # pragma: no cover
             logg.info("[%s] listen: new thread", me)
         if not self.systemctl._sockets:
+            os.close(self.stopping[0])
             return
         if DEBUG_INITLOOP: # pragma: no cover
             logg.info("[%s] listen: start thread", me)
         listen = select.poll()
+        listen.register(self.stopping[0], READ_ONLY)
+        listening = {} # fileno -> sock
         for sock in self.systemctl._sockets.values():
             listen.register(sock, READ_ONLY)
+            listening[sock.fileno()] = sock
             sock.listen()
             logg.debug("[%s] listen: %s :%s", me, sock.name(), sock.addr())
-        timestamp = time.time()
+        serving = {} # fileno -> sock, while its service is running
+        checking = time.time()
         while not self.stopped.is_set():
             try:
-                sleep_sec = InitLoopSleep - (time.time() - timestamp)
-                if sleep_sec < MinimumYield:
-                    sleep_sec = MinimumYield
-                sleeping = sleep_sec
-                while sleeping > 2:
-                    time.sleep(1) # accept signals atleast every second
-                    sleeping = InitLoopSleep - (time.time() - timestamp)
-                    if sleeping < MinimumYield:
-                       sleeping = MinimumYield
-                       break
-                time.sleep(sleeping) # remainder waits less that 2 seconds
+                timeouts = [] # seconds
+                if serving:
+                    timeouts.append(max(0, checking - time.time()))
+                timeout = min(timeouts) * 1000 if timeouts else None # milliseconds (0 = due)
                 if DEBUG_INITLOOP: # pragma: no cover
                     logg.debug("[%s] listen: poll", me)
-                accepting = listen.poll(100) # milliseconds
+                try:
+                    accepting = listen.poll(timeout)
+                except (select.error, OSError) as e:
+                    if e.args and e.args[0] == errno.EINTR:
+                        continue
+                    raise
                 if DEBUG_INITLOOP: # pragma: no cover
                     logg.debug("[%s] listen: poll (%s)", me, len(accepting))
                 for sock_fileno, event in accepting:
-                    for sock in self.systemctl._sockets.values():
-                        if sock.fileno() == sock_fileno:
-                            if not self.stopped.is_set():
-                                if self.systemctl.loop.acquire():
-                                    logg.debug("[%s] listen: accept %s :%s", me, sock.name(), sock_fileno)
-                                    self.systemctl.do_accept_socket_from(sock.conf, sock.sock)
+                    if sock_fileno not in listening or self.stopped.is_set():
+                        continue
+                    sock = listening[sock_fileno]
+                    logg.debug("[%s] listen: accept %s :%s", me, sock.name(), sock_fileno)
+                    if sock.conf.getbool("Socket", "Accept", "no"):
+                        self.systemctl.do_accept_connection_from(sock)
+                        continue
+                    done = self.systemctl.do_accept_socket_from(sock.conf, sock.sock)
+                    if done or self.readable(sock_fileno):
+                        listen.unregister(sock_fileno) # the service does accept (or it has failed)
+                        serving[sock_fileno] = listening.pop(sock_fileno)
+                        checking = time.time() + InitLoopSleep
+                if not serving or time.time() < checking:
+                    continue
+                checking = time.time() + InitLoopSleep
+                for sock_fileno, sock in list(serving.items()):
+                    service_unit = self.systemctl.get_socket_service_from(sock.conf)
+                    service_conf = self.systemctl.load_unit_conf(service_unit)
+                    if service_conf is None or not self.systemctl.is_active_from(service_conf):
+                        logg.debug("[%s] listen: again %s :%s", me, sock.name(), sock_fileno)
+                        listen.register(sock_fileno, READ_ONLY)
+                        listening[sock_fileno] = serving.pop(sock_fileno)
             except Exception as e:
                 logg.info("[%s] listen: interrupted - exception %s", me, e)
                 raise
+        os.close(self.stopping[0])
         for sock in self.systemctl._sockets.values():
             try:
-                listen.unregister(sock)
+                if sock.fileno() in listening:
+                    listen.unregister(sock)
                 sock.close()
             except Exception as e:
                 logg.warning("[%s] listen: close socket: %s", me, e)
         return
 
+class ControlOutput:
+    """ collects the printed output of a control socket request """
+    def __init__(self):
+        self.texts = []
+    def write(self, text):
+        self.texts.append(text)
+    def flush(self):
+        pass
+    def getvalue(self):
+        return "".join(self.texts)
+
+class ControlStdout:
+    """ the sys.stdout while the control thread runs - the output printed in a
+        control request goes to its ControlOutput, anything else to the real stdout """
+    def __init__(self, stdout):
+        self.stdout = stdout
+        self.pid = os.getpid() # a forked child writes to the real stdout
+        self.outputs = {} # thread ident => ControlOutput
+    def current(self):
+        if os.getpid() == self.pid:
+            output = self.outputs.get(threading.current_thread().ident)
+            if output is not None:
+                return output
+        return self.stdout
+    def write(self, text):
+        self.current().write(text)
+    def flush(self):
+        self.current().flush()
+    def __getattr__(self, name):
+        return getattr(self.stdout, name)
+
+class ControlLogFilter(logging.Filter):
+    """ the messages of a control request are sent to its client down to the
+        warnings - the level of the logger is not changed, instead its isEnabledFor
+        lets the warnings pass in the threads of a request, and for the handlers
+        of PID-1 only the records of its own level pass """
+    def __init__(self, logger):
+        logging.Filter.__init__(self)
+        self.enabled = logger.isEnabledFor # the Logger method
+        self.pid = os.getpid()
+        self.formatter = logging.Formatter(logging.BASIC_FORMAT)
+        self.errors = {} # thread ident => ControlOutput
+    def requested(self, ident):
+        if os.getpid() == self.pid:
+            return self.errors.get(ident)
+        return None # a forked child
+    def isEnabledFor(self, level):
+        if level >= logging.WARNING and self.requested(threading.current_thread().ident) is not None:
+            return True
+        return self.enabled(level)
+    def filter(self, record):
+        errors = self.requested(record.thread)
+        if errors is None:
+            return True
+        if record.levelno >= logging.WARNING:
+            errors.write(self.formatter.format(record) + "\n")
+        return self.enabled(record.levelno)
+
+class SystemctlControlThread(threading.Thread):
+    """ serves the control socket of PID-1 - each connection sends one json
+        request line and it gets back the output of that systemctl command. Each
+        connection is served in a thread of its own, so that an is-active does
+        not wait for a start that is still running. """
+    def __init__(self, systemctl):
+        threading.Thread.__init__(self, name="control")
+        self.systemctl = systemctl
+        self.stopped = threading.Event()
+        self.stopping = os.pipe()
+        self.sock = None
+        self.socketfile = systemctl.control_socket_file()
+    def listen(self):
+        try:
+            folder = os.path.dirname(self.socketfile)
+            if not os.path.isdir(folder):
+                os.makedirs(folder)
+            if os.path.exists(self.socketfile):
+                os.unlink(self.socketfile)
+            sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            fcntl.fcntl(sock.fileno(), fcntl.F_SETFD, fcntl.FD_CLOEXEC)
+            sock.bind(self.socketfile)
+            os.chmod(self.socketfile, 0o600)
+            sock.listen(MaxParallelJobs)
+        except (OSError, IOError, socket.error) as e:
+            logg.warning("can not listen on control socket %s: %s", self.socketfile, e)
+            return False
+        self.sock = sock
+        logg.debug("control: listen %s", self.socketfile)
+        return True
+    def stop(self):
+        self.stopped.set()
+        if self.sock and os.path.exists(self.socketfile):
+            os.unlink(self.socketfile) # the next clients run standalone
+        try:
+            os.write(self.stopping[1], b"x")
+        except OSError as e:
+            logg.debug("control: stopping %s", e) # the thread has closed the other end
+        os.close(self.stopping[1])
+    def run(self):
+        if not self.listen():
+            os.close(self.stopping[0])
+            return
+        assert self.sock is not None
+        stdout = sys.stdout
+        self.stdout = ControlStdout(stdout)
+        self.logfilter = ControlLogFilter(logg)
+        sys.stdout = self.stdout
+        logg.addFilter(self.logfilter)
+        logg.isEnabledFor = self.logfilter.isEnabledFor # type: ignore
+        try:
+            self.accepting()
+        finally:
+            del logg.isEnabledFor
+            logg.removeFilter(self.logfilter)
+            sys.stdout = stdout
+            os.close(self.stopping[0])
+            self.sock.close()
+    def accepting(self):
+        assert self.sock is not None
+        while not self.stopped.is_set():
+            try:
+                readable, _, _ = select.select([ self.sock, self.stopping[0] ], [], [])
+            except (select.error, OSError) as e:
+                if e.args and e.args[0] == errno.EINTR:
+                    continue
+                raise
+            if self.sock not in readable or self.stopped.is_set():
+                continue
+            try:
+                conn, _ = self.sock.accept()
+                fcntl.fcntl(conn.fileno(), fcntl.F_SETFD, fcntl.FD_CLOEXEC) # not in the started services
+            except socket.error as e:
+                logg.debug("control: accept %s", e)
+                continue
+            serving = threading.Thread(target=self.serving, args=(conn,), name="control-request")
+            serving.daemon = True # a request that is still running does not hold up the exit
+            serving.start()
+    def serving(self, conn):
+        try:
+            self.serve(conn)
+        except Exception as e:
+            logg.warning("control: request failed: %s", e)
+        finally:
+            conn.close()
+    def serve(self, conn):
+        conn.settimeout(InitLoopSleep) # a client sends its request at once
+        data = b""
+        while not data.endswith(b"\n"):
+            chunk = conn.recv(65536)
+            if not chunk:
+                break
+            data += chunk
+        request = json.loads(data.decode("utf-8"), object_hook = json_str_hook)
+        me = threading.current_thread().ident
+        output = ControlOutput()
+        errors = ControlOutput()
+        self.stdout.outputs[me] = output
+        self.logfilter.errors[me] = errors
+        try:
+            exitcode = self.systemctl.control_request(request)
+        finally:
+            del self.stdout.outputs[me]
+            del self.logfilter.errors[me]
+        reply = { "stdout": output.getvalue(), "stderr": errors.getvalue(), "exitcode": exitcode }
+        conn.settimeout(None)
+        conn.sendall(json.dumps(reply).encode("utf-8"))
+
 class Systemctl:
     def __init__(self):
         self.error = NOT_A_PROBLEM # program exitcode or process returncode
@@ -1178,6 +1952,7 @@ class Systemctl:
         self._quiet = _quiet
         self._root = _root
         self._show_all = _show_all
+        self._timings = _timings
         self._unit_property = _unit_property
         self._unit_state = _unit_state
         self._unit_type = _unit_type
@@ -1189,6 +1964,10 @@ class Systemctl:
         self._loaded_file_sysd = {} # /etc/systemd/system/name.service => config data
         self._file_for_unit_sysv = None # name.service => /etc/init.d/name
         self._file_for_unit_sysd = None # name.service => /etc/systemd/system/name.service
+        self._unit_cache = None # the content of the unit-files cache (of daemon-reload)
+        self._unit_cache_sysv_folders = [] # [ [folder, mtime], ... ] when scanned
+        self._unit_cache_sysd_folders = [] # [ [folder, mtime], ... ] when scanned
+        self._unit_cache_sysd_confs = {} # /etc/systemd/system/name.service => cache entry
         self._preset_file_list = None # /etc/systemd/system-preset/* => file content
         self._default_target = DefaultTarget
         self._sysinit_target = None # stores a UnitConf()
@@ -1198,13 +1977,35 @@ class Systemctl:
         self._user_getlogin = os_getlogin()
         self._log_file = {} # init-loop
         self._log_hold = {} # init-loop
+        self._log_tee = {} # init-loop journal log fd of a fifo (JOURNAL_PIPES)
+        self._log_index = {} # init-loop journal index fd and its last timestamp
+        self._accepted = None # fd 3 in an Accept=yes instance process
+        self._cgroup_base = None # the folder of the unit cgroups ("" when not CGROUP_TRACKING)
+        self._read_only = False # a query command that does not write (see ReadOnlyCommands)
+        self._log_forwarder = None # still running for the fifos (JOURNAL_PIPES)
         self._boottime = None # cache self.get_boottime()
         self._SYSTEMD_UNIT_PATH = None
         self._SYSTEMD_SYSVINIT_PATH = None
         self._SYSTEMD_PRESET_PATH = None
-        self._restarted_unit = {}
-        self._restart_failed_units = {}
+        self._restarted_unit = {} # name.service => [ time of each restart in the StartLimitIntervalSec ]
+        self._restart_failed_units = {} # name.service => time of the next restart
+        self._restart_backoff = {} # name.service => (restarts in a row, time of the last one)
         self._sockets = {}
+        self._loop_wakeup = None # init-loop (read, write) pipe of SIGCHLD
+        self._loop_timers = [] # init-loop heap of (deadline, unit)
+        self._running_procs = None # cache self.count_running_procs()
+        self._reaped_zombies = 0 # by the init-loop (metrics)
+        self._restart_counts = {} # name.service => restarts by the init-loop (metrics)
+        self._start_seconds = {} # name.service => [ count per bucket, count, sum ] (metrics)
+        self._loop_ticks = [ 0, 0. ] # init-loop ticks and the seconds they took (metrics)
+        self._metrics_written = 0. # time of the last metrics textfile
+        self._dependencies = {} # (name.service, styles) => { dep.service: style }
+        self._status_files = {} # /run/name.service.status => ((ino, size, mtime), status)
+        self._env_files = {} # EnvironmentFile path => ((mtime, size), [(name, value)])
+        self._special_confs = {} # (name.service, filename) => { specifier: value }
+        self._proc_snapshot = None # a ProcTable while checking many units (batchstates)
+        self._status_folders = None # folder => set(names) while checking many units (batchstates)
+        self._dependencies_closure = {} # (name.service, styles) => { dep.service: [style] }
         self.loop = threading.Lock()
     def user(self):
         return self._user_getlogin
@@ -1293,6 +2094,12 @@ class Systemctl:
     def scan_unit_sysd_files(self, module = None): # -> [ unit-names,... ]
         """ reads all unit files, returns the first filename for the unit given """
         if self._file_for_unit_sysd is None:
+            self._unit_cache_sysd_folders = self.unit_cache_folders(self.sysd_folders())
+            cache = self.unit_cache()
+            if cache.get("sysd_folders") == self._unit_cache_sysd_folders:
+                self._file_for_unit_sysd = collections.OrderedDict(cache["sysd_units"])
+                logg.debug("cached %s sysd files", len(self._file_for_unit_sysd))
+                return list(self._file_for_unit_sysd.keys())
             self._file_for_unit_sysd = {}
             for folder in self.sysd_folders():
                 if not folder: 
@@ -1312,6 +2119,12 @@ class Systemctl:
     def scan_unit_sysv_files(self, module = None): # -> [ unit-names,... ]
         """ reads all init.d files, returns the first filename when unit is a '.service' """
         if self._file_for_unit_sysv is None:
+            self._unit_cache_sysv_folders = self.unit_cache_folders(self.init_folders())
+            cache = self.unit_cache()
+            if cache.get("sysv_folders") == self._unit_cache_sysv_folders:
+                self._file_for_unit_sysv = collections.OrderedDict(cache["sysv_units"])
+                logg.debug("cached %s sysv files", len(self._file_for_unit_sysv))
+                return list(self._file_for_unit_sysv.keys())
             self._file_for_unit_sysv = {}
             for folder in self.init_folders():
                 if not folder: 
@@ -1405,6 +2218,138 @@ class Systemctl:
                 if name not in result:
                     result[name] = path
         return result
+    def unit_cache_file(self):
+        return os_path(self._root, expand_path(_unit_file_cache, not self.user_mode()))
+    def refresh_unit_files(self):
+        """ forget about the unit files that have changed since they were loaded
+            (a long running PID-1 shall answer like a new systemctl call) """
+        changed = False
+        if self._file_for_unit_sysd is not None:
+            if self._unit_cache_sysd_folders != self.unit_cache_folders(self.sysd_folders()):
+                self._file_for_unit_sysd = None
+                self._loaded_file_sysd = {}
+                self._unit_cache_sysd_confs = {}
+                changed = True
+        if self._file_for_unit_sysv is not None:
+            if self._unit_cache_sysv_folders != self.unit_cache_folders(self.init_folders()):
+                self._file_for_unit_sysv = None
+                self._loaded_file_sysv = {}
+                changed = True
+        for path, entry in list(self._unit_cache_sysd_confs.items()):
+            if path not in self._loaded_file_sysd:
+                continue
+            unit = os.path.basename(path)
+            drop_in_dirs = self.unit_cache_folders([ os.path.join(folder, unit + ".d") for folder in self.sysd_folders() if folder ])
+            if entry["drop_in_dirs"] != drop_in_dirs or entry["files"] != self.unit_cache_files([ item[0] for item in entry["files"] ]):
+                del self._loaded_file_sysd[path]
+                del self._unit_cache_sysd_confs[path]
+                changed = True
+        if changed:
+            logg.debug("unit files have changed")
+            self._unit_cache = None
+            self._dependencies = {}
+            self._dependencies_closure = {}
+        return changed
+    def unit_cache(self):
+        """ the unit files cache as written by daemon-reload (or an empty dict) """
+        if self._unit_cache is None:
+            self._unit_cache = {}
+            cache_file = self.unit_cache_file()
+            if UNIT_FILE_CACHE and os.path.isfile(cache_file):
+                try:
+                    f = open(cache_file)
+                    cache = json.load(f, object_hook = json_str_hook)
+                    f.close()
+                    if cache.get("version") == __version__:
+                        self._unit_cache = cache
+                except Exception as e:
+                    logg.debug("can not read unit files cache %s: %s", cache_file, e)
+        return self._unit_cache
+    def unit_cache_folders(self, folders):
+        """ [ [folder, mtime], ... ] - a new or removed unit file changes the folder mtime """
+        result = []
+        for folder in folders:
+            if not folder:
+                continue
+            folder = os_path(self._root, folder)
+            try:
+                mtime = os.stat(folder).st_mtime
+            except OSError:
+                mtime = None
+            result.append([ folder, mtime ])
+        return result
+    def unit_cache_files(self, filenames):
+        """ [ [filename, mtime, size], ... ] of the parsed files """
+        result = []
+        for filename in filenames:
+            try:
+                st = os.stat(filename)
+                result.append([ filename, st.st_mtime, st.st_size ])
+            except OSError:
+                result.append([ filename, None, None ])
+        return result
+    def write_unit_cache(self):
+        """ store the parsed unit files (see daemon-reload) """
+        if not UNIT_FILE_CACHE:
+            return False
+        self.scan_unit_sysd_files()
+        self.scan_unit_sysv_files()
+        assert self._file_for_unit_sysd is not None
+        assert self._file_for_unit_sysv is not None
+        cache = {}
+        cache["version"] = __version__
+        cache["sysd_folders"] = self._unit_cache_sysd_folders
+        cache["sysd_units"] = list(self._file_for_unit_sysd.items())
+        cache["sysv_folders"] = self._unit_cache_sysv_folders
+        cache["sysv_units"] = list(self._file_for_unit_sysv.items())
+        cache["sysd_confs"] = self._unit_cache_sysd_confs
+        cache_file = self.unit_cache_file()
+        try:
+            cache_folder = os.path.dirname(cache_file)
+            if not os.path.isdir(cache_folder):
+                os.makedirs(cache_folder)
+            cache_temp = path_temp_name(cache_file)
+            f = open(cache_temp, "w")
+            json.dump(cache, f)
+            f.close()
+            os.rename(cache_temp, cache_file)
+        except Exception as e:
+            logg.warning("can not write unit files cache %s: %s", cache_file, e)
+            return False
+        self._unit_cache = cache
+        return True
+    def load_sysd_unit_data(self, path): # -> (data, drop_in_files)
+        """ parse the unit file and its drop-in files - unless the daemon-reload
+            has stored the parsed data of the same files in the unit files cache """
+        unit = os.path.basename(path)
+        drop_in_dirs = self.unit_cache_folders([ os.path.join(folder, unit + ".d") for folder in self.sysd_folders() if folder ])
+        entry = self.unit_cache().get("sysd_confs", {}).get(path)
+        if entry and entry["drop_in_dirs"] == drop_in_dirs:
+            if entry["files"] == self.unit_cache_files([ item[0] for item in entry["files"] ]):
+                data = UnitConfParser()
+                for section, options in entry["conf"]:
+                    data.add_section(section)
+                    for option, values in options:
+                        data._conf[section][option] = list(values)
+                data._files = [ item[0] for item in entry["files"] ]
+                self._unit_cache_sysd_confs[path] = entry
+                return data, collections.OrderedDict(entry["drop_in_files"])
+        data = UnitConfParser()
+        drop_in_files = self.find_drop_in_files(unit)
+        files = self.unit_cache_files([ path ] + [ drop_in_files[name] for name in sorted(drop_in_files) ])
+        data.read_sysd(path)
+        # load in alphabetic order, irrespective of location
+        for name in sorted(drop_in_files):
+            data.read_sysd(drop_in_files[name])
+        if len(files) < len(data.filenames()): # .include
+            files = self.unit_cache_files(data.filenames())
+        entry = {}
+        entry["files"] = files
+        entry["drop_in_dirs"] = drop_in_dirs
+        entry["drop_in_files"] = [ (name, drop_in_files[name]) for name in sorted(drop_in_files) ]
+        entry["conf"] = [ (section, list(data._conf[section].items())) for section in data.sections() ]
+        self._unit_cache_sysd_confs[path] = entry
+        return data, drop_in_files
     def load_sysd_template_conf(self, module): # -> conf?
         """ read the unit template with a UnitConfParser (systemd) """
         if module and "@" in module:
@@ -1428,12 +2373,7 @@ class Systemctl:
         drop_in_files = {}
         data = UnitConfParser()
         if not masked:
-            data.read_sysd(path)
-            drop_in_files = self.find_drop_in_files(os.path.basename(path))
-            # load in alphabetic order, irrespective of location
-            for name in sorted(drop_in_files):
-                path = drop_in_files[name]
-                data.read_sysd(path)
+            data, drop_in_files = self.load_sysd_unit_data(path)
         conf = SystemctlConf(data, module)
         conf.masked = masked
         conf.nonloaded_path = path # if masked
@@ -1574,22 +2514,23 @@ class Systemctl:
         active = {}
         substate = {}
         description = {}
-        for unit in self.match_units(to_list(modules)):
-            result[unit] = "not-found"
-            active[unit] = "inactive"
-            substate[unit] = "dead"
-            description[unit] = ""
-            try: 
-                conf = self.get_unit_conf(unit)
-                result[unit] = "loaded"
-                description[unit] = self.get_description_from(conf)
-                active[unit] = self.get_active_from(conf)
-                substate[unit] = self.get_substate_from(conf) or "unknown"
-            except Exception as e:
-                logg.warning("list-units: %s", e)
-            if self._unit_state:
-                if self._unit_state not in [ result[unit], active[unit], substate[unit] ]:
-                    del result[unit]
+        with batchstates(self):
+            for unit in self.match_units(to_list(modules)):
+                result[unit] = "not-found"
+                active[unit] = "inactive"
+                substate[unit] = "dead"
+                description[unit] = ""
+                try: 
+                    conf = self.get_unit_conf(unit)
+                    result[unit] = "loaded"
+                    description[unit] = self.get_description_from(conf)
+                    active[unit] = self.get_active_from(conf)
+                    substate[unit] = self.get_substate_from(conf) or "unknown"
+                except Exception as e:
+                    logg.warning("list-units: %s", e)
+                if self._unit_state:
+                    if self._unit_state not in [ result[unit], active[unit], substate[unit] ]:
+                        del result[unit]
         return [ (unit, result[unit] + " " + active[unit] + " " + substate[unit], description[unit]) for unit in sorted(result) ]
     def show_list_units(self, *modules): # -> [ (unit,loaded,description) ]
         """ [PATTERN]... -- List loaded units.
@@ -1703,19 +2644,29 @@ class Systemctl:
         timeout = int(timeout or (DefaultTimeoutStartSec/2))
         timeout = max(timeout, (MinimumTimeoutStartSec))
         dirpath = os.path.dirname(os.path.abspath(pid_file))
-        for x in xrange(timeout):
-            if not os.path.isdir(dirpath):
-                time.sleep(1) # until TimeoutStartSec/2
-                continue
-            pid = self.read_pid_file(pid_file)
-            if not pid:
-                time.sleep(1) # until TimeoutStartSec/2
-                continue
-            if not pid_exists(pid):
-                time.sleep(1) # until TimeoutStartSec/2
-                continue
-            return pid
-        return None
+        deadline = time.time() + timeout # until TimeoutStartSec/2
+        watch = inotify_watch()
+        watched = False
+        backoff = 0.05 # seconds, doubled up to 1.0
+        try:
+            while True:
+                if os.path.isdir(dirpath):
+                    if watch and not watched:
+                        watched = watch.add(dirpath)
+                    pid = self.read_pid_file(pid_file)
+                    if pid and pid_exists(pid):
+                        return pid
+                now = time.time()
+                if now >= deadline:
+                    return None
+                if watched:
+                    watch.wait(min(deadline - now, 1.0))
+                else:
+                    time.sleep(min(deadline - now, backoff))
+                    backoff = min(backoff * 2, 1.0)
+        finally:
+            if watch:
+                watch.close()
     def test_pid_file(self, unit): # -> text
         """ support for the testsuite.py """
         conf = self.get_unit_conf(unit)
@@ -1764,6 +2715,7 @@ class Systemctl:
         status_file = self.get_status_file_from(conf)
         if os.path.exists(status_file):
             os.remove(status_file)
+        self._status_files.pop(status_file, None)
         conf.status = {}
     def write_status_from(self, conf, **status): # -> bool(written)
         """ if a status_file is known then path is created and the
@@ -1785,29 +2737,64 @@ class Systemctl:
                     except KeyError: pass
                 else:
                     conf.status[key] = strE(value)
+        written = {}
+        for key in sorted(conf.status):
+            value = conf.status[key]
+            if key == "MainPID" and str(value) == "0":
+                logg.warning("ignore writing MainPID=0")
+                continue
+            written[key] = str(value).strip()
+        cached = self._status_files.get(status_file)
+        if cached and cached[1] == written and cached[0] == self.status_file_stat(status_file):
+            if DEBUG_STATUS: logg.debug("unchanged status file %s", status_file)
+            return True
+        status_temp = path_temp_name(status_file)
         try:
-            with open(status_file, "w") as f:
-                for key in sorted(conf.status):
-                    value = conf.status[key]
-                    if key == "MainPID" and str(value) == "0":
-                        logg.warning("ignore writing MainPID=0")
-                        continue
-                    content = "{}={}\n".format(key, str(value))
+            with open(status_temp, "w") as f:
+                for key in sorted(written):
+                    content = "{}={}\n".format(key, written[key])
                     logg.debug("writing to %s\n\t%s", status_file, content.strip())
                     f.write(content)
-        except IOError as e:
+            os.rename(status_temp, status_file)
+            self._status_files[status_file] = (self.status_file_stat(status_file), written)
+        except (IOError, OSError) as e:
             logg.error("writing STATUS %s: %s\n\t to status file %s", status, e, status_file)
+            if os.path.exists(status_temp):
+                os.remove(status_temp)
         return True
+    def status_file_missing(self, status_file):
+        """ when checking many units the status folder is listed once (batchstates) """
+        if self._status_folders is None:
+            return False
+        folder, name = os.path.split(status_file)
+        if folder not in self._status_folders:
+            try:
+                self._status_folders[folder] = set(os.listdir(folder))
+            except OSError:
+                self._status_folders[folder] = set()
+        return name not in self._status_folders[folder]
+    def status_file_stat(self, status_file):
+        """ a changed inode/size/mtime tells that another process has written the file """
+        try:
+            st = os.stat(status_file)
+            return (st.st_ino, st.st_size, st.st_mtime)
+        except OSError:
+            return None
     def read_status_from(self, conf):
         status_file = self.get_status_file_from(conf)
         status = {}
         # if not status_file: return status
-        if not os.path.isfile(status_file):
+        if self.status_file_missing(status_file) or not os.path.isfile(status_file):
             if DEBUG_STATUS: logg.debug("no status file: %s\n returning %s", status_file, status)
             return status
         if self.truncate_old(status_file):
             if DEBUG_STATUS: logg.debug("old status file: %s\n returning %s", status_file, status)
             return status
+        status_stat = self.status_file_stat(status_file)
+        cached = self._status_files.get(status_file)
+        if cached and cached[0] == status_stat:
+            if DEBUG_STATUS: logg.debug("unchanged status file %s", status_file)
+            return dict(cached[1])
         try:
             if DEBUG_STATUS: logg.debug("reading %s", status_file)
             for line in open(status_file):
@@ -1819,6 +2806,7 @@ class Systemctl:
                             status[key.strip()] = value.strip()
                     else: #pragma: no cover
                         logg.warning("ignored %s", line.strip())
+            self._status_files[status_file] = (status_stat, dict(status))
         except:
             logg.warning("bad read of status file '%s'", status_file)
         return status
@@ -1834,6 +2822,18 @@ class Systemctl:
             except KeyError: pass
         else:
             conf.status[name] = value
+    def set_timing_from(self, conf, phase, usec = None, wait = None):
+        """ remember the monotonic time of a start/stop phase (--timings), it is
+            written to the status file along with the next ActiveState change """
+        if self._timings:
+            self.set_status_from(conf, "Timing" + phase, strE(usec or monotonic_usec()))
+            if wait:
+                self.set_status_from(conf, "TimingStartWait", wait)
+    def get_timings_from(self, conf):
+        """ the Timing* phases in the status file (see analyze) """
+        if conf.status is None:
+            conf.status = self.read_status_from(conf)
+        return dict([ (key, value) for key, value in conf.status.items() if key.startswith("Timing") ])
     #
     def get_boottime(self):
         """ detects the boot time of the container - in general the start time of PID 1 """
@@ -1852,7 +2852,7 @@ class Systemctl:
             try:
                 if os.path.exists(proc):
                     # return os.path.getmtime(proc) # did sometimes change
-                    return self.path_proc_started(proc)
+                    return self.path_proc_started_cached(proc)
             except Exception as e: # pragma: no cover
                 logg.warning("boottime - could not access %s: %s", proc, e)
         if DEBUG_BOOTTIME:
@@ -1872,6 +2872,36 @@ class Systemctl:
                 logg.warning("could not access %s: %s", proc, e)
         return booted
 
+    def boottime_cache_file(self):
+        return os_path(self._root, expand_path(_boottime_cache, not self.user_mode()))
+    def path_proc_started_cached(self, proc):
+        """ the path_proc_started() of the boot process is stored in a small file along
+            with its start time in clock ticks, so that it is not computed on each call.
+            A read-only command does only use the cache file but it does not write it. """
+        with open(proc) as file_stat:
+            data_stat = file_stat.readline()
+        started_ticks = data_stat[data_stat.rfind(")")+2:].split()[19]
+        cache_file = self.boottime_cache_file()
+        try:
+            with open(cache_file) as f:
+                cached = f.readline().split() # proc starttime boottime
+            if len(cached) == 3 and cached[0] == proc and cached[1] == started_ticks:
+                if DEBUG_BOOTTIME:
+                    logg.debug("  BOOT .. cached boot time: %s (%s)", cached[2], cache_file)
+                return float(cached[2])
+        except (IOError, OSError, ValueError):
+            pass
+        booted = self.path_proc_started(proc)
+        if not self._read_only and os.path.isdir(os.path.dirname(cache_file)):
+            try:
+                cache_temp = path_temp_name(cache_file)
+                with open(cache_temp, "w") as f:
+                    f.write("%s %s %.6f\n" % (proc, started_ticks, booted))
+                os.rename(cache_temp, cache_file)
+            except (IOError, OSError) as e:
+                logg.debug("can not write boot time cache %s: %s", cache_file, e)
+        return booted
+
     # Use uptime, time process running in ticks, and current time to determine process boot time
     # You can't use the modified timestamp of the status file because it isn't static.
     # ... using clock ticks it is known to be a linear time on Linux
@@ -1938,6 +2968,11 @@ class Systemctl:
                 logg.debug("  file time: %s (%s)", datetime.datetime.fromtimestamp(filetime), o22(filename))
                 logg.debug("  boot time: %s (%s)", datetime.datetime.fromtimestamp(boottime), "status modified later")
             return False # OK
+        if self._read_only:
+            if DEBUG_BOOTTIME:
+                logg.debug("  file time: %s (%s)", datetime.datetime.fromtimestamp(filetime), o22(filename))
+                logg.debug("  boot time: %s (%s)", datetime.datetime.fromtimestamp(boottime), "status is old (read-only)")
+            return True # without a lock it may have been replaced in between
         if DEBUG_BOOTTIME:
             logg.info("  file time: %s (%s)", datetime.datetime.fromtimestamp(filetime), o22(filename))
             logg.info("  boot time: %s (%s)", datetime.datetime.fromtimestamp(boottime), "status TRUNCATED NOW")
@@ -1949,7 +2984,7 @@ class Systemctl:
     def getsize(self, filename):
         if filename is None: # pragma: no cover (is never null)
             return 0
-        if not os.path.isfile(filename):
+        if self.status_file_missing(filename) or not os.path.isfile(filename):
             return 0
         if self.truncate_old(filename):
             return 0
@@ -1960,30 +2995,40 @@ class Systemctl:
             return 0
     #
     def read_env_file(self, env_file): # -> generate[ (name,value) ]
-        """ EnvironmentFile=<name> is being scanned """
+        """ EnvironmentFile=<name> is being scanned (once for each mtime) """
         if env_file.startswith("-"):
             env_file = env_file[1:]
             if not os.path.isfile(os_path(self._root, env_file)):
                 return
+        filename = os_path(self._root, env_file)
         try:
-            for real_line in open(os_path(self._root, env_file)):
-                line = real_line.strip()
-                if not line or line.startswith("#"):
-                    continue
-                m = re.match(r"(?:export +)?([\w_]+)[=]'([^']*)'", line)
-                if m:
-                    yield m.group(1), m.group(2)
-                    continue
-                m = re.match(r'(?:export +)?([\w_]+)[=]"([^"]*)"', line)
-                if m:
-                    yield m.group(1), m.group(2)
-                    continue
-                m = re.match(r'(?:export +)?([\w_]+)[=](.*)', line)
-                if m:
-                    yield m.group(1), m.group(2)
-                    continue
-        except Exception as e:
+            st = os.stat(filename)
+            mark = (st.st_mtime, st.st_size)
+        except OSError as e:
             logg.info("while reading %s: %s", env_file, e)
+            return
+        cached = self._env_files.get(filename)
+        if cached is None or cached[0] != mark:
+            items = []
+            try:
+                for real_line in open(filename):
+                    line = real_line.strip()
+                    if not line or line.startswith("#"):
+                        continue
+                    m = _env_file_single_quoted.match(line)
+                    if not m:
+                        m = _env_file_double_quoted.match(line)
+                    if not m:
+                        m = _env_file_unquoted.match(line)
+                    if m:
+                        items.append((m.group(1), m.group(2)))
+                cached = (mark, items)
+                self._env_files[filename] = cached
+            except Exception as e:
+                logg.info("while reading %s: %s", env_file, e)
+                cached = (mark, items)
+        for name, value in cached[1]:
+            yield name, value
     def read_env_part(self, env_part): # -> generate[ (name, value) ]
         """ Environment=<name>=<value> is being scanned """
         ## systemd Environment= spec says it is a space-seperated list of 
@@ -1994,7 +3039,7 @@ class Systemctl:
         try:
             for real_line in env_part.split("\n"):
                 line = real_line.strip()
-                for found in re.finditer(r'\s*("[\w_]+=[^"]*"|[\w_]+=\S*)', line):
+                for found in _env_part_assignment.finditer(line):
                     part = found.group(1)
                     if part.startswith('"'):
                         part = part[1:-1]
@@ -2049,9 +3094,12 @@ class Systemctl:
             return (EXPAND_KEEP_VARS and namevar or "")
         #
         maxdepth = EXPAND_VARS_MAXDEPTH
-        expanded = re.sub("[$](\w+)", lambda m: get_env1(m), cmd.replace("\\\n",""))
+        expanded = cmd.replace("\\\n","")
+        if "$" not in expanded:
+            return expanded
+        expanded = _expand_env_var.sub(get_env1, expanded)
         for depth in xrange(maxdepth):
-            new_text = re.sub("[$][{](\w+)[}]", lambda m: get_env2(m), expanded)
+            new_text = _expand_env_braced.sub(get_env2, expanded)
             if new_text == expanded:
                 return expanded
             expanded = new_text
@@ -2110,16 +3158,22 @@ class Systemctl:
             confs["U"] = str(USER_ID)
             confs["V"] = os_path(self._root, VARTMP)
             return confs
-        def get_conf1(m):
+        if not cmd:
+            return ""
+        if "%" not in cmd:
+            return cmd
+        key = conf is not None and (conf.name(), conf.filename()) or None
+        confs = self._special_confs.get(key)
+        if confs is None:
             confs = get_confs(conf)
+            self._special_confs[key] = confs
+        def get_conf1(m):
             if m.group(1) in confs:
                 return confs[m.group(1)]
             logg.warning("can not expand %%%s", m.group(1))
             return ""
-        result = ""
-        if cmd:
-            result = re.sub("[%](.)", lambda m: get_conf1(m), cmd)
-            #++# logg.info("expanded => %s", result)
+        result = _expand_special_var.sub(get_conf1, cmd)
+        #++# logg.info("expanded => %s", result)
         return result
     ExecMode = collections.namedtuple("ExecMode", ["check"])
     def exec_newcmd(self, cmd, env, conf):
@@ -2143,11 +3197,16 @@ class Systemctl:
                 return env[m.group(1)]
             logg.debug("can not expand ${%s}", m.group(1))
             return "" # empty string
-        cmd3 = re.sub("[$](\w+)", lambda m: get_env1(m), cmd2)
+        if "$" in cmd2:
+            cmd3 = _expand_env_var.sub(get_env1, cmd2) # may be empty
+        else:
+            cmd3 = cmd2
         newcmd = []
         for part in shlex.split(cmd3):
-            # newcmd += [ re.sub("[$][{](\w+)[}]", lambda m: get_env2(m), part) ]
-            newcmd += [ re.sub("[$][{](\w+)[}]", lambda m: get_env2(m), self.expand_special(part, conf)) ]
+            part = self.expand_special(part, conf)
+            if "$" in part:
+                part = _expand_env_braced.sub(get_env2, part)
+            newcmd += [ part ]
         return newcmd
     def remove_service_directories(self, conf, section = "Service"):
         ok = True
@@ -2409,8 +3468,14 @@ class Systemctl:
             return True
         if user or group:
             st = os.stat(dirpath)
-            st_user = pwd.getpwuid(st.st_uid).pw_name
-            st_group = grp.getgrgid(st.st_gid).gr_name
+            try:
+                st_user = pwd.getpwuid(st.st_uid).pw_name
+            except KeyError:
+                st_user = str(st.st_uid) # a uid from another image
+            try:
+                st_group = grp.getgrgid(st.st_gid).gr_name
+            except KeyError:
+                st_group = str(st.st_gid)
             change = False
             if user and (user.strip() != st_user and user.strip() != str(st.st_uid)):
                 change = True
@@ -2428,6 +3493,8 @@ class Systemctl:
                 logg.debug("untouched %s", dirpath)
         return True
     def do_chown_tree(self, path, user, group):
+        """ the folders are scanned level by level in some threads (ChownParallelJobs),
+            with lchown for the entries that do not have the uid/gid already """
         ok = True
         uid, gid = -1, -1
         if user:
@@ -2435,21 +3502,15 @@ class Systemctl:
             gid = pwd.getpwnam(user).pw_gid
         if group:
             gid = grp.getgrnam(group).gr_gid
-        for dirpath, dirnames, filenames in os.walk(path, topdown=False):
-            for item in filenames:
-                filepath = os.path.join(dirpath, item)
-                try: 
-                    os.chown(filepath, uid, gid)
-                except Exception as e: # pragma: no cover
-                    logg.debug("could not set %s:%s on %s\n\t%s", user, group, filepath, e)
-                    ok = False
-            for item in dirnames:
-                dir_path = os.path.join(dirpath, item)
-                try: 
-                    os.chown(dir_path, uid, gid)
-                except Exception as e: # pragma: no cover
-                    logg.debug("could not set %s:%s on %s\n\t%s", user, group, dir_path, e)
-                    ok = False
+        def chown_folder(dirpath):
+            return self.do_chown_folder(dirpath, uid, gid, user, group)
+        folders = [ path ]
+        while folders:
+            results = thread_map(chown_folder, folders, ChownParallelJobs)
+            folders = []
+            for subfolders, done in results:
+                folders += subfolders
+                ok = ok and done
         try: 
             os.chown(path, uid, gid)
         except Exception as e: # pragma: no cover
@@ -2458,6 +3519,34 @@ class Systemctl:
         if not ok:
             logg.debug("could not chown %s:%s service directory %s", user, group, path)
         return ok
+    def do_chown_folder(self, dirpath, uid, gid, user, group): # -> (subfolders, ok)
+        """ the entries of one folder - a symlink is changed itself but never followed """
+        ok = True
+        subfolders = []
+        try:
+            if hasattr(os, "scandir"):
+                entries = [ (entry.path, entry.is_dir(follow_symlinks=False), entry.stat(follow_symlinks=False))
+                            for entry in os.scandir(dirpath) ]
+            else:
+                entries = []
+                for name in os.listdir(dirpath):
+                    filepath = os.path.join(dirpath, name)
+                    st = os.lstat(filepath)
+                    entries.append((filepath, stat.S_ISDIR(st.st_mode), st))
+        except Exception as e: # pragma: no cover
+            logg.debug("could not scan %s\n\t%s", dirpath, e)
+            return subfolders, False
+        for filepath, is_dir, st in entries:
+            if is_dir:
+                subfolders.append(filepath)
+            if (uid == -1 or st.st_uid == uid) and (gid == -1 or st.st_gid == gid):
+                continue
+            try: 
+                os.lchown(filepath, uid, gid)
+            except Exception as e: # pragma: no cover
+                logg.debug("could not set %s:%s on %s\n\t%s", user, group, filepath, e)
+                ok = False
+        return subfolders, ok
     def clean_modules(self, *modules):
         """ [UNIT]... -- remove the state directories
         /// it recognizes --what=all or any of configuration, state, cache, logs, runtime
@@ -2532,6 +3621,10 @@ class Systemctl:
         return self.log_unit_from(conf, lines, follow)
     def log_unit_from(self, conf, lines = None, follow = False):
         log_path = self.get_journal_log_from(conf)
+        if _log_since or _log_until:
+            return self.read_journal_log(conf, lines, follow)
+        if LOG_READER and (follow or lines or _no_pager or not sys.stdout.isatty() or not os.path.exists(LESS_CMD)):
+            return self.read_journal_log(conf, lines, follow)
         if follow:
             cmd = [ TAIL_CMD, "-n", str(lines or 10), "-F", log_path ]
             logg.debug("journalctl %s -> %s", conf.name(), cmd)
@@ -2548,6 +3641,82 @@ class Systemctl:
             cmd = [ LESS_CMD, log_path ]
             logg.debug("journalctl %s -> %s", conf.name(), cmd)
             return os.spawnvp(os.P_WAIT, cmd[0], cmd) # type: ignore
+    def read_journal_log(self, conf, lines = None, follow = False):
+        """ the journal log to stdout without tail/cat - seeking backwards for '-n',
+            using the journal index for '--since'/'--until' and inotify for '-f' """
+        log_path = self.get_journal_log_from(conf)
+        since = until = None
+        for option, text in [ ("--since", _log_since), ("--until", _log_until) ]:
+            if not text: continue
+            stamp = journal_time(text)
+            if stamp is None:
+                logg.error("Failed to parse timestamp: %s %s", option, text)
+                return NOT_OK
+            if option == "--since":
+                since = stamp
+            else:
+                until = stamp
+        if follow and not lines:
+            lines = 10
+        if not os.path.exists(log_path) and not follow:
+            logg.error("no journal log for %s: %s", conf.name(), log_path)
+            return NOT_OK
+        logg.debug("journalctl %s -> %s (lines %s, since %s, until %s)", conf.name(), log_path, lines, since, until)
+        opened = None
+        watch = None
+        try:
+            pos = inode = 0
+            if os.path.exists(log_path):
+                opened = os.open(log_path, os.O_RDONLY)
+                st = os.fstat(opened)
+                inode = st.st_ino
+                start, pos = journal_index_range(self.get_journal_index_from(conf), st.st_size, since, until)
+                if since is not None and st.st_mtime < since:
+                    start = pos # nothing written since then
+                if lines:
+                    start = journal_tail_offset(opened, start, pos, int(lines))
+                if not journal_copy(opened, start, pos):
+                    return NOT_A_PROBLEM
+                if until is not None and pos < st.st_size:
+                    return NOT_A_PROBLEM
+            if not follow:
+                return NOT_A_PROBLEM
+            watch = inotify_watch()
+            watched = False
+            while until is None or time.time() <= until:
+                if watch and not watched and os.path.isdir(os.path.dirname(log_path)):
+                    watched = watch.add(os.path.dirname(log_path), IN_CREATE | IN_MOVED_TO | IN_MODIFY)
+                try:
+                    st = os.stat(log_path)
+                except OSError:
+                    st = None
+                if st and st.st_ino != inode:
+                    if opened is not None:
+                        os.close(opened)
+                    opened = os.open(log_path, os.O_RDONLY)
+                    st = os.fstat(opened)
+                    pos, inode = 0, st.st_ino # like 'tail -F'
+                if st and st.st_size < pos:
+                    pos = 0 # truncated
+                if st and st.st_size > pos:
+                    if not journal_copy(opened, pos, st.st_size):
+                        break
+                    pos = st.st_size
+                if watched:
+                    watch.wait(1.0)
+                else:
+                    time.sleep(LogForwardPollSec)
+        except KeyboardInterrupt:
+            pass
+        finally:
+            if watch:
+                watch.close()
+            if opened is not None:
+                os.close(opened)
+        return NOT_A_PROBLEM
+    def get_journal_index_from(self, conf):
+        """ /var/log/journal/zzz.service.log.idx """
+        return self.get_journal_log_from(conf) + ".idx"
     def get_journal_log_from(self, conf):
         return os_path(self._root, self.get_journal_log(conf))
     def get_journal_log(self, conf):
@@ -2560,7 +3729,28 @@ class Systemctl:
         if log_file.startswith("."):
             log_file = "dot."+log_file
         return os.path.join(log_folder, log_file)
+    def get_journal_pipe_from(self, conf):
+        """ /run/journal/zzz.service.fifo """
+        pipe_folder = expand_path(_journal_pipe_folder, conf.root_mode())
+        pipe_name = os.path.basename(self.get_journal_log(conf))[:-len(".log")] + ".fifo"
+        return os_path(self._root, os.path.join(pipe_folder, pipe_name))
+    def open_journal_pipe(self, conf):
+        """ the fifo to PID-1 - or None if there is nobody reading it """
+        pipe_file = self.get_journal_pipe_from(conf)
+        try:
+            if not stat.S_ISFIFO(os.stat(pipe_file).st_mode):
+                return None
+            piped = os.open(pipe_file, os.O_WRONLY | os.O_NONBLOCK) # ENXIO if no reader
+        except OSError as e:
+            logg.debug("no journal pipe %s: %s", pipe_file, e)
+            return None
+        fcntl.fcntl(piped, fcntl.F_SETFL, fcntl.fcntl(piped, fcntl.F_GETFL) & ~os.O_NONBLOCK)
+        return os.fdopen(piped, "w")
     def open_journal_log(self, conf):
+        if JOURNAL_PIPES:
+            piped = self.open_journal_pipe(conf)
+            if piped is not None:
+                return piped
         log_file = self.get_journal_log_from(conf)
         log_folder = os.path.dirname(log_file)
         if not os.path.isdir(log_folder):
@@ -2651,52 +3841,97 @@ class Systemctl:
             if timeout > 2:
                 logg.debug("socket.timeout %s", e)
         return result
+    def read_notify_datagrams(self, notify):
+        """ all the messages that are waiting on the notify socket (non-blocking) """
+        notify.socket.setblocking(False)
+        result = ""
+        while True:
+            try:
+                message, client_address = notify.socket.recvfrom(4096)
+            except socket.error as e:
+                if e.errno in [ errno.EAGAIN, errno.EWOULDBLOCK, errno.EINTR ]:
+                    break
+                raise
+            assert isinstance(message, bytes)
+            if not message:
+                break
+            message = message.decode("utf-8")
+            logg.debug("read_notify_socket(%s):%s", len(message), message.replace("\n","|"))
+            result += message + "\n"
+        return result
     def wait_notify_socket(self, notify, timeout, pid = None, pid_file = None):
+        """ block on the notify socket (and a pidfd of the main pid) until the
+            service is READY with a MAINPID, or it has died, or the timeout is over """
         if not os.path.exists(notify.socketfile):
             logg.info("no $NOTIFY_SOCKET exists")
             return {}
         #
         lapseTimeout = max(3, int(timeout / 100)) 
-        mainpidTimeout = lapseTimeout # Apache sends READY before MAINPID
         status = ""
         logg.info("wait $NOTIFY_SOCKET, timeout %s (lapse %s)", timeout, lapseTimeout)
         waiting = " ---"
         results = {}
-        for attempt in xrange(int(timeout)+1):
-            if pid and not self.is_active_pid(pid):
-                logg.info("seen dead PID %s", pid)
-                return results
-            if not attempt: # first one
-                time.sleep(1) # until TimeoutStartSec
-                continue
-            result = self.read_notify_socket(notify, 1) # sleep max 1 second
-            for line in result.splitlines():
-                # for name, value in self.read_env_part(line)
-                if "=" not in line:
+        started = time.time()
+        deadline = started + timeout # TimeoutStartSec
+        mainpid_deadline = None # Apache sends READY before MAINPID
+        pidfd = pid and pid_open(pid)
+        poller = select.poll()
+        poller.register(notify.socket.fileno(), select.POLLIN)
+        if pidfd is not None:
+            poller.register(pidfd, select.POLLIN)
+        backoff = 0.05 # seconds, doubled up to 1.0
+        try:
+            while True:
+                if pid and not self.is_active_pid(pid):
+                    logg.info("seen dead PID %s", pid)
+                    return results
+                now = time.time()
+                wait_until = deadline
+                if mainpid_deadline is not None:
+                    wait_until = min(wait_until, mainpid_deadline)
+                if now >= wait_until:
+                    break
+                wait_secs = wait_until - now
+                if pid and pidfd is None: # check the pid from time to time
+                    wait_secs = min(wait_secs, backoff)
+                    backoff = min(backoff * 2, 1.0)
+                try:
+                    events = poller.poll(int(wait_secs * 1000) + 1)
+                except (select.error, OSError) as e:
+                    if e.args and e.args[0] == errno.EINTR:
+                        continue
+                    raise
+                if not [ fd for fd, event in events if fd == notify.socket.fileno() ]:
                     continue
-                name, value = line.split("=", 1)
-                results[name] = value
-                if name in ["STATUS", "ACTIVESTATE", "MAINPID", "READY"]:
-                    hint="seen notify %s     " % (waiting)
-                    logg.debug("%s :%s=%s", hint, name, value)
-            if status != results.get("STATUS",""):
-                mainpidTimeout = lapseTimeout
-                status = results.get("STATUS", "")
-            if "READY" not in results:
-                time.sleep(1) # until TimeoutStart
-                continue
-            if "MAINPID" not in results and not pid_file:
-                mainpidTimeout -= 1
-                if mainpidTimeout > 0:
-                    waiting = "%4i" % (-mainpidTimeout)
-                    time.sleep(1) # until TimeoutStart
+                result = self.read_notify_datagrams(notify)
+                for line in result.splitlines():
+                    # for name, value in self.read_env_part(line)
+                    if "=" not in line:
+                        continue
+                    name, value = line.split("=", 1)
+                    results[name] = value
+                    if name in ["STATUS", "ACTIVESTATE", "MAINPID", "READY"]:
+                        hint="seen notify %s     " % (waiting)
+                        logg.debug("%s :%s=%s", hint, name, value)
+                if status != results.get("STATUS",""):
+                    mainpid_deadline = None
+                    status = results.get("STATUS", "")
+                if "READY" not in results:
+                    continue
+                if "MAINPID" not in results and not pid_file:
+                    if mainpid_deadline is None:
+                        mainpid_deadline = time.time() + lapseTimeout
+                    waiting = "%4i" % (time.time() - mainpid_deadline)
                     continue
-            break # READY and MAINPID
+                break # READY and MAINPID
+        finally:
+            if pidfd is not None:
+                os.close(pidfd)
         if "READY" not in results:
             logg.info(".... timeout while waiting for 'READY=1' status on $NOTIFY_SOCKET")
         elif "MAINPID" not in results:
             logg.info(".... seen 'READY=1' but no MAINPID update status on $NOTIFY_SOCKET")
-        logg.debug("notify = %s", results)
+        logg.debug("notify = %s (after %.3fs)", results, time.time() - started)
         try:
             notify.socket.close()
         except Exception as e:
@@ -2727,7 +3962,19 @@ class Systemctl:
         self.wait_system()
         done = True
         started_units = []
+        if init:
+            self.init_cgroups()
+        if init and JOURNAL_PIPES:
+            self.start_journal_pipes(units)
+        if MaxParallelJobs > 1 and len(units) > 1:
+            started_units = self.sortedAfter(units)
+            results = self.parallel_jobs(started_units, self.start_jobs_requires(started_units), self.start_unit)
+            for unit in started_units:
+                if not results.get(unit):
+                    done = False
         for unit in self.sortedAfter(units):
+            if unit in started_units:
+                continue
             started_units.append(unit)
             if not self.start_unit(unit):
                 done = False
@@ -2735,9 +3982,117 @@ class Systemctl:
             logg.info("init-loop start")
             sig = self.init_loop_until_stop(started_units)
             logg.info("init-loop %s", sig)
-            for unit in reversed(started_units):
-                self.stop_unit(unit)
+            self.stop_started_units(started_units)
+            if self._log_tee:
+                self.stop_journal_pipes(started_units)
+            self.done_cgroups()
+        return done
+    def stop_started_units(self, started_units):
+        """ stop in reverse order - independent units concurrently """
+        stop_units = list(reversed(started_units))
+        maxjobs = max(MaxParallelJobs, InitStopParallelJobs)
+        if maxjobs > 1 and len(stop_units) > 1:
+            results = self.parallel_jobs(stop_units, self.stop_jobs_requires(stop_units), self.stop_unit, maxjobs)
+            return not [ unit for unit in stop_units if not results.get(unit) ]
+        done = True
+        for unit in stop_units:
+            if not self.stop_unit(unit):
+                done = False
         return done
+    def start_jobs_requires(self, units):
+        """ the units in the list that must be started before another one """
+        graph = SortedAfterGraph([ self.get_unit_conf(unit) for unit in units ])
+        requires = {}
+        for unit in units:
+            conf = self.get_unit_conf(unit)
+            deps = " ".join(conf.getlist("Unit", "Requires", []) + conf.getlist("Unit", "BindsTo", [])).split()
+            requires[unit] = graph.requires(unit)
+            for dep in units:
+                if dep != unit and dep in deps and dep not in requires[unit]:
+                    requires[unit].append(dep)
+        return requires
+    def stop_jobs_requires(self, units):
+        """ the units in the list that must be stopped before another one """
+        requires = dict([(unit, []) for unit in units])
+        for unit, deps in self.start_jobs_requires(units).items():
+            for dep in deps:
+                requires[dep].append(unit)
+        return requires
+    def parallel_jobs(self, units, requires, job, maxjobs = None):
+        """ run the job for each unit in a forked worker process (at most MaxParallelJobs
+            at the same time) where a unit has to wait for the units it requires. Each
+            worker is waited for by its own pid (not stealing other exit statuses) as soon
+            as it has written to its done-pipe (or it has gone away without). """
+        maxjobs = maxjobs or MaxParallelJobs
+        results = {}
+        workers = {} # pid => unit
+        started = {} # pid => time
+        donepipes = {} # pid => fd
+        waiting = list(units)
+        while waiting or workers:
+            for unit in list(waiting):
+                if len(workers) >= maxjobs:
+                    break
+                if [ dep for dep in requires.get(unit, []) if dep in waiting or dep in workers.values() ]:
+                    continue
+                waiting.remove(unit)
+                done_r, done_w = os.pipe()
+                for fd in [ done_r, done_w ]:
+                    fcntl.fcntl(fd, fcntl.F_SETFD, fcntl.fcntl(fd, fcntl.F_GETFD) | fcntl.FD_CLOEXEC)
+                pid = os.fork()
+                if not pid: # pragma: no cover (is the worker process)
+                    os.close(done_r)
+                    exitcode = NOT_OK
+                    try:
+                        if job(unit):
+                            exitcode = NOT_A_PROBLEM
+                    except BaseException as e:
+                        logg.error("%s: %s", unit, e)
+                    try:
+                        sys.stdout.flush()
+                        sys.stderr.flush()
+                        os.write(done_w, b"x")
+                    except BaseException:
+                        pass
+                    os._exit(exitcode)
+                os.close(done_w)
+                logg.debug("[%s] job for %s", pid, unit)
+                workers[pid] = unit
+                started[pid] = time.time()
+                donepipes[pid] = done_r
+            if not workers:
+                logg.error("dependency loop in %s", waiting)
+                for unit in waiting:
+                    results[unit] = job(unit)
+                break
+            try:
+                readable, _, _ = select.select(list(donepipes.values()), [], [], 1.0)
+            except (select.error, OSError) as e:
+                if e.args and e.args[0] == errno.EINTR:
+                    continue
+                raise
+            for pid in list(workers):
+                try:
+                    done, run_stat = reaped_waitpid(pid, 0 if donepipes[pid] in readable else os.WNOHANG)
+                except OSError as e:
+                    if e.errno == errno.EINTR:
+                        continue
+                    if e.errno != errno.ECHILD:
+                        raise
+                    logg.warning("[%s] job for %s: no exit status", pid, workers[pid])
+                    done, run_stat = pid, NOT_OK << 8
+                if done != pid:
+                    continue
+                os.close(donepipes.pop(pid))
+                unit = workers.pop(pid)
+                results[unit] = os.WIFEXITED(run_stat) and os.WEXITSTATUS(run_stat) == NOT_A_PROBLEM
+                if job == self.start_unit: # the worker did note it in its own process
+                    self.note_start_seconds(unit, time.time() - started.pop(pid))
+                logg.debug("[%s] job for %s done (%s)", pid, unit, results[unit] and "OK" or "failed")
+                conf = self.load_unit_conf(unit)
+                if conf is not None:
+                    conf.status = None # was changed by the worker
+        return results
     def start_unit(self, unit):
         conf = self.load_unit_conf(unit)
         if conf is None:
@@ -2760,9 +4115,30 @@ class Systemctl:
     def start_unit_from(self, conf):
         if not conf: return False
         if self.syntax_check(conf) > 100: return False
+        began = monotonic_usec()
         with waitlock(conf):
             logg.debug(" start unit %s => %s", conf.name(), strQ(conf.filename()))
-            return self.do_start_unit_from(conf)
+            if self._timings:
+                for key in self.get_timings_from(conf):
+                    self.set_status_from(conf, key, None)
+                self.set_timing_from(conf, "StartBegin", began)
+                self.set_timing_from(conf, "StartLocked")
+            done = self.do_start_unit_from(conf)
+            self.note_start_seconds(conf.name(), (monotonic_usec() - began) / 1000000.)
+            if self._timings:
+                self.set_timing_from(conf, "StartDone")
+                self.write_status_from(conf)
+            return done
+    def note_start_seconds(self, unit, seconds):
+        """ the start latency histogram of the metrics textfile """
+        if unit not in self._start_seconds:
+            self._start_seconds[unit] = [ 0 for bucket in _metrics_start_buckets ] + [ 0, 0. ]
+        histogram = self._start_seconds[unit]
+        for idx, bucket in enumerate(_metrics_start_buckets):
+            if seconds <= bucket:
+                histogram[idx] += 1
+        histogram[-2] += 1
+        histogram[-1] += seconds
     def do_start_unit_from(self, conf):
         if conf.name().endswith(".service"):
             return self.do_start_service_from(conf)
@@ -2783,18 +4159,18 @@ class Systemctl:
             if not okee and _no_reload: return False
         service_directories = self.create_service_directories(conf)
         env.update(service_directories) # atleast sshd did check for /run/sshd
+        self.cgroup_create_from(conf)
         # for StopPost on failure:
         returncode = 0
         service_result = "success"
         if True:
             if runs in [ "simple", "forking", "notify", "idle" ]:
                 env["MAINPID"] = strE(self.read_mainpid_from(conf))
+            self.set_timing_from(conf, "StartPre")
             for cmd in conf.getlist("Service", "ExecStartPre", []):
                 exe, newcmd = self.exec_newcmd(cmd, env, conf)
                 logg.info(" pre-start %s", shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid: 
-                    self.execve_from(conf, newcmd, env) # pragma: no cover
+                forkpid = self.spawn_from(conf, newcmd, env)
                 run = subprocess_waitpid(forkpid)
                 logg.debug(" pre-start done (%s) <-%s>",
                     run.returncode or "OK", run.signal or "")
@@ -2805,6 +4181,7 @@ class Systemctl:
                     if _what_kind not in ["none", "keep"]:
                         self.remove_service_directories(conf) # cleanup that /run/sshd
                     return False
+        self.set_timing_from(conf, "StartExec")
         if runs in [ "oneshot" ]:
             status_file = self.get_status_file_from(conf)
             if self.get_status_from(conf, "ActiveState", "unknown") == "active":
@@ -2813,10 +4190,7 @@ class Systemctl:
             for cmd in conf.getlist("Service", "ExecStart", []):
                 exe, newcmd = self.exec_newcmd(cmd, env, conf)
                 logg.info("%s start %s", runs, shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid: # pragma: no cover
-                    os.setsid() # detach child process from parent
-                    self.execve_from(conf, newcmd, env)
+                forkpid = self.spawn_from(conf, newcmd, env, setsid = True)
                 run = subprocess_waitpid(forkpid)
                 if run.returncode and exe.check: 
                     returncode = run.returncode
@@ -2826,6 +4200,7 @@ class Systemctl:
                     break
                 logg.info("%s start done (%s) <-%s>", runs, 
                     run.returncode or "OK", run.signal or "")
+            self.set_timing_from(conf, "StartReady", wait = "exit")
             if True:
                 self.set_status_from(conf, "ExecMainCode", strE(returncode))
                 active = returncode and "failed" or "active"
@@ -2847,10 +4222,7 @@ class Systemctl:
                 env["MAINPID"] = strE(pid)
                 exe, newcmd = self.exec_newcmd(cmd, env, conf)
                 logg.info("%s start %s", runs, shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid: # pragma: no cover
-                    os.setsid() # detach child process from parent
-                    self.execve_from(conf, newcmd, env)
+                forkpid = self.spawn_from(conf, newcmd, env, setsid = True)
                 self.write_status_from(conf, MainPID=forkpid)
                 logg.info("%s started PID %s", runs, forkpid)
                 env["MAINPID"] = strE(forkpid)
@@ -2866,6 +4238,7 @@ class Systemctl:
                     if run.returncode and exe.check:
                         service_result = "failed"
                         break
+            self.set_timing_from(conf, "StartReady", wait = "sleep")
         elif runs in [ "notify" ]:
             # "notify" is the same as "simple" but we create a $NOTIFY_SOCKET 
             # and wait for startup completion by checking the socket messages
@@ -2890,10 +4263,7 @@ class Systemctl:
                 env["MAINPID"] = strE(mainpid)
                 exe, newcmd = self.exec_newcmd(cmd, env, conf)
                 logg.info("%s start %s", runs, shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid: # pragma: no cover
-                    os.setsid() # detach child process from parent
-                    self.execve_from(conf, newcmd, env)
+                forkpid = self.spawn_from(conf, newcmd, env, setsid = True)
                 # via NOTIFY # self.write_status_from(conf, MainPID=forkpid)
                 logg.info("%s started PID %s", runs, forkpid)
                 mainpid = forkpid
@@ -2914,6 +4284,7 @@ class Systemctl:
             if service_result in [ "success" ] and mainpid:
                 logg.debug("okay, wating on socket for %ss", timeout)
                 results = self.wait_notify_socket(notify, timeout, mainpid, pid_file)
+                self.set_timing_from(conf, "StartReady", wait = "notify")
                 if "MAINPID" in results:
                     new_pid = to_intN(results["MAINPID"])
                     if new_pid and new_pid != mainpid:
@@ -2932,10 +4303,7 @@ class Systemctl:
                 exe, newcmd = self.exec_newcmd(cmd, env, conf)
                 if not newcmd: continue
                 logg.info("%s start %s", runs, shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid: # pragma: no cover
-                    os.setsid() # detach child process from parent
-                    self.execve_from(conf, newcmd, env)
+                forkpid = self.spawn_from(conf, newcmd, env, setsid = True)
                 logg.info("%s started PID %s", runs, forkpid)
                 run = subprocess_waitpid(forkpid)
                 if run.returncode and exe.check:
@@ -2945,11 +4313,13 @@ class Systemctl:
                     run.returncode or "OK", run.signal or "")
             if pid_file and service_result in [ "success" ]:
                 pid = self.wait_pid_file(pid_file) # application PIDFile
+                self.set_timing_from(conf, "StartReady", wait = "pidfile")
                 logg.info("%s start done PID %s [%s]", runs, pid, pid_file)
                 if pid:
                     env["MAINPID"] = strE(pid)
             if not pid_file:
                 time.sleep(MinimumTimeoutStartSec)
+                self.set_timing_from(conf, "StartReady", wait = "sleep")
                 logg.warning("No PIDFile for forking %s", strQ(conf.filename()))
                 status_file = self.get_status_file_from(conf)
                 self.set_status_from(conf, "ExecMainCode", strE(returncode))
@@ -2967,9 +4337,7 @@ class Systemctl:
             for cmd in conf.getlist("Service", "ExecStopPost", []):
                 exe, newcmd = self.exec_newcmd(cmd, env, conf)
                 logg.info("post-fail %s", shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid:
-                    self.execve_from(conf, newcmd, env) # pragma: no cover
+                forkpid = self.spawn_from(conf, newcmd, env)
                 run = subprocess_waitpid(forkpid)
                 logg.debug("post-fail done (%s) <-%s>", 
                     run.returncode or "OK", run.signal or "")
@@ -2977,12 +4345,11 @@ class Systemctl:
                 self.remove_service_directories(conf)
             return False
         else:
+            self.set_timing_from(conf, "StartPost")
             for cmd in conf.getlist("Service", "ExecStartPost", []):
                 exe, newcmd = self.exec_newcmd(cmd, env, conf)
                 logg.info("post-start %s", shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid:
-                    self.execve_from(conf, newcmd, env) # pragma: no cover
+                forkpid = self.spawn_from(conf, newcmd, env)
                 run = subprocess_waitpid(forkpid)
                 logg.debug("post-start done (%s) <-%s>", 
                     run.returncode or "OK", run.signal or "")
@@ -3061,7 +4428,96 @@ class Systemctl:
                 return False
             logg.error("can not accept socket type %s", strINET(sock.type))
             return False
-        return self.do_start_service_from(service_conf)
+        return self.do_start_service_from(service_conf) # a reaped child is seen in reaped_waitpid
+    def do_accept_connection_from(self, sock):
+        """ Accept=yes - start a name@instance.service for a new connection in a thread
+            of its own (see serve_connection_from), so the listen thread does not wait. """
+        conf = sock.conf
+        conn, addr = sock.sock.accept()
+        try:
+            source, instance = socket_connection_names(conn, addr, sock.accepted)
+            sock.accepted += 1
+            maxconnections = self.get_MaxConnections(conf)
+            if len(sock.connections) >= maxconnections:
+                logg.warning("%s: too many incoming connections (%s)", conf.name(), maxconnections)
+                conn.close()
+                return None
+            maxconnectionspersource = self.get_MaxConnectionsPerSource(conf)
+            sources = [ connected for connected, _ in list(sock.connections.values()) ]
+            if sources.count(source) >= maxconnectionspersource:
+                logg.warning("%s: too many incoming connections from %s (%s)", conf.name(), source, maxconnectionspersource)
+                conn.close()
+                return None
+            service_template = self.get_socket_service_from(conf)
+            service_unit = service_template.replace("@.", "@%s." % instance, 1)
+            template_conf = self.load_sysd_template_conf(service_unit)
+            if template_conf is None:
+                logg.error("Unit %s not found.", service_template)
+                conn.close()
+                return None
+            service_conf = copy.copy(template_conf) # with a status of its own
+            service_conf.module = service_unit
+            service_conf.status = None
+            service_conf.env = dict(template_conf.env)
+            logg.info("%s: accepted %s -> %s", conf.name(), source, service_unit)
+            accepting = copy.copy(self)
+            accepting._accepted = conn.fileno()
+            sock.connections[service_unit] = (source, service_conf)
+            serving = threading.Thread(target=accepting.serve_connection_from, args=(sock, service_conf, conn), name=service_unit)
+            serving.daemon = True # stopping the socket does stop the instances
+            serving.start()
+            return serving
+        except Exception:
+            conn.close()
+            raise
+    def serve_connection_from(self, sock, conf, conn):
+        """ the thread of an Accept=yes instance - it is started like any other unit
+            (and the connection is passed as fd 3, see dup2_connection). When its MainPID
+            has exited then it is stopped (ExecStop/ExecStopPost) and its status is removed. """
+        try:
+            try:
+                started = self.start_unit_from(conf)
+            finally:
+                conn.close()
+                self._accepted = None
+            if started: # a failed start has run its ExecStopPost already
+                pid = self.read_mainpid_from(conf)
+                pidfd = pid and pid_open(pid)
+                if pidfd:
+                    try:
+                        select.select([ pidfd ], [], []) # readable when the process has exited
+                    finally:
+                        os.close(pidfd)
+                while self.is_active_pid(pid):
+                    time.sleep(MinimumYield)
+                self.stop_unit_from(conf)
+            self.clean_status_from(conf)
+        except Exception as e:
+            logg.error("%s: connection failed: %s", conf.name(), e)
+        finally:
+            logg.debug("%s: connection done", conf.name())
+            sock.connections.pop(conf.name(), None)
+    def dup2_connection(self, env):
+        """ the connection of an Accept=yes instance on fd 3 - as with sd_listen_fds """
+        os.dup2(self._accepted, 3)
+        if hasattr(os, "set_inheritable"):
+            os.set_inheritable(3, True)
+        env["LISTEN_FDS"] = "1"
+        env["LISTEN_PID"] = strE(os.getpid())
+        env["LISTEN_FDNAMES"] = "connection"
+        self._accepted = 3
+    def get_MaxConnections(self, conf):
+        return to_int(conf.get("Socket", "MaxConnections", strE(DefaultMaxConnections)), DefaultMaxConnections)
+    def get_MaxConnectionsPerSource(self, conf):
+        maxconnections = self.get_MaxConnections(conf)
+        return to_int(conf.get("Socket", "MaxConnectionsPerSource", strE(maxconnections)), maxconnections)
+    def is_socket_accept_instances(self, conf):
+        """ Accept=yes on a ListenStream with a name@.service - each connection is an instance """
+        if not conf.getbool("Socket", "Accept", "no"):
+            return False
+        if not conf.get("Socket", "ListenStream", ""):
+            return False
+        return "@." in self.get_socket_service_from(conf)
     def get_socket_service_from(self, conf):
         socket_unit = conf.name()
         accept = conf.getbool("Socket", "Accept", "no")
@@ -3089,9 +4545,7 @@ class Systemctl:
             for cmd in conf.getlist("Socket", "ExecStartPre", []):
                 exe, newcmd = self.exec_newcmd(cmd, env, conf)
                 logg.info(" pre-start %s", shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid: 
-                    self.execve_from(conf, newcmd, env) # pragma: no cover
+                forkpid = self.spawn_from(conf, newcmd, env)
                 run = subprocess_waitpid(forkpid)
                 logg.debug(" pre-start done (%s) <-%s>",
                     run.returncode or "OK", run.signal or "")
@@ -3111,6 +4565,15 @@ class Systemctl:
                 service_result = "success"
                 state = sock and "active" or "failed"
                 self.write_status_from(conf, AS=state)
+        elif self.is_socket_accept_instances(conf):
+            # the init-loop will spawn an instance for each connection
+            sock = self.create_socket(conf)
+            listening=True
+            service_result = sock and "success" or "failed"
+            if sock:
+                self._sockets[conf.name()] = SystemctlSocket(conf, sock)
+            state = sock and "active" or "failed"
+            self.write_status_from(conf, AS=state)
         if not listening:
             # we do not listen but have the service started right away
             done = self.do_start_service_from(service_conf)
@@ -3129,9 +4592,7 @@ class Systemctl:
             for cmd in conf.getlist("Socket", "ExecStopPost", []):
                 exe, newcmd = self.exec_newcmd(cmd, env, conf)
                 logg.info("post-fail %s", shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid:
-                    self.execve_from(conf, newcmd, env) # pragma: no cover
+                forkpid = self.spawn_from(conf, newcmd, env)
                 run = subprocess_waitpid(forkpid)
                 logg.debug("post-fail done (%s) <-%s>", 
                     run.returncode or "OK", run.signal or "")
@@ -3140,9 +4601,7 @@ class Systemctl:
             for cmd in conf.getlist("Socket", "ExecStartPost", []):
                 exe, newcmd = self.exec_newcmd(cmd, env, conf)
                 logg.info("post-start %s", shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid:
-                    self.execve_from(conf, newcmd, env) # pragma: no cover
+                forkpid = self.spawn_from(conf, newcmd, env)
                 run = subprocess_waitpid(forkpid)
                 logg.debug("post-start done (%s) <-%s>", 
                     run.returncode or "OK", run.signal or "")
@@ -3286,6 +4745,118 @@ class Systemctl:
         return self.expand_special(conf.get("Service", "Group", ""), conf)
     def get_SupplementaryGroups(self, conf):
         return self.expand_list(conf.getlist("Service", "SupplementaryGroups", []), conf)
+    def get_Nice(self, conf): # -> int?
+        value = conf.get("Service", "Nice", "").strip()
+        if not value:
+            return None
+        nice = to_intN(value)
+        if nice is None or nice < -20 or nice > 19:
+            logg.error(" %s: bad Nice=%s", conf.name(), value)
+            return None
+        return nice
+    def get_CPUAffinity(self, conf): # -> [cpu]
+        cpus = []
+        for value in conf.getlist("Service", "CPUAffinity", []):
+            if not value.strip():
+                cpus = [] # an empty assignment resets the list
+            for part in value.replace(",", " ").split():
+                first, _, last = part.partition("-")
+                if to_intN(first) is None or to_intN(last or first) is None:
+                    logg.error(" %s: bad CPUAffinity=%s", conf.name(), value)
+                    return []
+                for cpu in range(int(first), int(last or first) + 1):
+                    if cpu not in cpus:
+                        cpus.append(cpu)
+        return sorted(cpus)
+    def get_IOSchedulingClass(self, conf): # -> str?
+        value = conf.get("Service", "IOSchedulingClass", "").strip()
+        if not value:
+            return None
+        if to_intN(value) is not None:
+            for name, ioclass in IOPRIO_CLASSES.items():
+                if ioclass == int(value):
+                    return name
+        if value not in IOPRIO_CLASSES:
+            logg.error(" %s: bad IOSchedulingClass=%s", conf.name(), value)
+            return None
+        return value
+    def get_IOSchedulingPriority(self, conf): # -> int?
+        value = conf.get("Service", "IOSchedulingPriority", "").strip()
+        if not value:
+            return None
+        level = to_intN(value)
+        if level is None or level < 0 or level > 7:
+            logg.error(" %s: bad IOSchedulingPriority=%s", conf.name(), value)
+            return None
+        return level
+    def get_OOMScoreAdjust(self, conf): # -> int?
+        value = conf.get("Service", "OOMScoreAdjust", "").strip()
+        if not value:
+            return None
+        adjust = to_intN(value)
+        if adjust is None or adjust < -1000 or adjust > 1000:
+            logg.error(" %s: bad OOMScoreAdjust=%s", conf.name(), value)
+            return None
+        return adjust
+    def get_Limits(self, conf): # -> [(name, soft, hard)]
+        """ the LimitXY=soft:hard settings of the unit for setrlimit """
+        limits = []
+        for name in [ "CPU", "FSIZE", "DATA", "STACK", "CORE", "RSS", "NOFILE", "AS", "NPROC",
+                      "MEMLOCK", "LOCKS", "SIGPENDING", "MSGQUEUE", "NICE", "RTPRIO", "RTTIME" ]:
+            value = conf.get("Service", "Limit" + name, "").strip()
+            if not value:
+                continue
+            values = []
+            for part in value.split(":", 1):
+                if part.strip() == "infinity":
+                    values.append(resource.RLIM_INFINITY)
+                else:
+                    values.append(size_to_bytes(part))
+            if None in values:
+                logg.error(" %s: bad Limit%s=%s", conf.name(), name, value)
+                continue
+            limits.append(("Limit" + name, values[0], values[-1]))
+        return limits
+    def exec_context_from(self, conf):
+        """ the rlimits and the cpu/io scheduling of the unit - done in the
+            forked process before the setuid (that may drop the privileges) """
+        for name, soft, hard in self.get_Limits(conf):
+            rlimit = getattr(resource, "RLIMIT_" + name[len("Limit"):], None)
+            if rlimit is None:
+                logg.error("%s: no %s on this system", conf.name(), name)
+                continue
+            try:
+                resource.setrlimit(rlimit, (soft, hard))
+            except (ValueError, OSError) as e:
+                logg.error("%s: can not set %s=%s:%s: %s", conf.name(), name, soft, hard, e)
+        nice = self.get_Nice(conf)
+        if nice is not None:
+            try:
+                os.nice(nice - os.nice(0))
+            except OSError as e:
+                logg.error("%s: can not set Nice=%s: %s", conf.name(), nice, e)
+        cpus = self.get_CPUAffinity(conf)
+        if cpus:
+            if not hasattr(os, "sched_setaffinity"):
+                logg.error("%s: no CPUAffinity on this python", conf.name())
+            else:
+                try:
+                    os.sched_setaffinity(0, cpus)
+                except OSError as e:
+                    logg.error("%s: can not set CPUAffinity=%s: %s", conf.name(), cpus, e)
+        ioclass = self.get_IOSchedulingClass(conf)
+        level = self.get_IOSchedulingPriority(conf)
+        if ioclass is not None or level is not None:
+            if not ioprio_set(IOPRIO_CLASSES[ioclass or "best-effort"], 4 if level is None else level):
+                logg.error("%s: can not set IOSchedulingClass=%s", conf.name(), ioclass or "best-effort")
+        adjust = self.get_OOMScoreAdjust(conf)
+        if adjust is not None:
+            try:
+                f = open(_proc_self_oom_score_adj, "w")
+                f.write(str(adjust))
+                f.close()
+            except (OSError, IOError) as e:
+                logg.error("%s: can not set OOMScoreAdjust=%s: %s", conf.name(), adjust, e)
     def skip_journal_log(self, conf):
         if self.get_unit_type(conf.name()) not in [ "service" ]:
            return True
@@ -3300,6 +4871,23 @@ class Systemctl:
         if std_err.startswith("append:"): err = True
         return out and err
     def dup2_journal_log(self, conf):
+        inp, out, err = self.open_journal_files(conf)
+        if EXEC_DUP2:
+            os.dup2(inp.fileno(), sys.stdin.fileno())
+            os.dup2(out.fileno(), sys.stdout.fileno())
+            os.dup2(err.fileno(), sys.stderr.fileno())
+    def open_journal_files(self, conf):
+        """ the stdin, stdout and stderr for the exec process of the unit """
+        inp, out, err, msg = self.journal_files_from(conf)
+        if msg:
+            err.write("ERROR:")
+            err.write(msg.strip())
+            err.write("\n")
+            err.flush()
+        return inp, out, err
+    def journal_files_from(self, conf):
+        """ open the stdin, stdout and stderr of the unit - and the message for the
+            files that could not be opened (see open_journal_files) """
         msg = ""
         std_inp = conf.get("Service", "StandardInput", DefaultStandardInput)
         std_out = conf.get("Service", "StandardOutput", DefaultStandardOutput)
@@ -3307,6 +4895,8 @@ class Systemctl:
         inp, out, err = None, None, None
         if std_inp in ["null"]:
             inp = open(_dev_null, "r")
+        elif std_inp in ["socket"] and self._accepted is not None:
+            inp = os.fdopen(os.dup(self._accepted), "r")
         elif std_inp.startswith("file:"):
             fname = std_inp[len("file:"):]
             if os.path.exists(fname):
@@ -3331,6 +4921,9 @@ class Systemctl:
                 if not os.path.exists(fdir):
                     os.makedirs(fdir)
                 out = open(fname, "a")
+            elif std_inp in ["socket"] and self._accepted is not None:
+                if conf.get("Service", "StandardOutput", "inherit") in ["inherit", "socket"]:
+                    out = os.fdopen(os.dup(self._accepted), "w")
         except Exception as e:
             msg += "\n%s: %s" % (fname, e)
         if out is None:
@@ -3359,19 +4952,90 @@ class Systemctl:
         if err is None:
             err = self.open_journal_log(conf)
         assert err is not None
+        return inp, out, err, msg
+    def spawn_from(self, conf, cmd, env, setsid = False):
+        """ start the exec process of the unit // returns the pid """
+        pid = self.posix_spawn_from(conf, cmd, env, setsid)
+        if pid:
+            return pid
+        forkpid = os.fork()
+        if not forkpid: # pragma: no cover
+            self.execve_child(conf, cmd, env, setsid and os.setsid or None)
+        return forkpid
+    def execve_child(self, conf, cmd, env, prepare = None):
+        """ run execve_from in the forked child and leave only through os._exit - a
+            sys.exit in a child forked from a thread would only end that thread and
+            the child would go on as a copy of the systemctl process """
+        exitcode = NOT_OK
+        try:
+            if prepare:
+                prepare() # e.g. detach child process from parent
+            self.execve_from(conf, cmd, env)
+        except SystemExit as e:
+            if e.code is None:
+                exitcode = NOT_A_PROBLEM
+            elif isinstance(e.code, int):
+                exitcode = e.code
+        except BaseException as e:
+            logg.error("(%s): %s", shell_cmd(cmd), e)
+        finally:
+            try:
+                sys.stdout.flush()
+                sys.stderr.flush()
+            finally:
+                os._exit(exitcode)
+    def posix_spawn_from(self, conf, cmd, env, setsid = False):
+        """ without a second python process when all of execve_from can
+            be done upfront in the parent // returns the pid or None """
+        if not EXEC_POSIX_SPAWN or EXEC_SPAWN or not EXEC_DUP2 or not hasattr(os, "posix_spawn"):
+            return None
+        if self._accepted is not None or JOURNAL_PIPES or self.cgroup_from(conf):
+            return None
+        if self.get_User(conf) or self.get_Group(conf):
+            return None # setuid needs a child process
+        if self.get_Limits(conf) or self.get_CPUAffinity(conf) or self.get_Nice(conf) is not None:
+            return None
+        if self.get_IOSchedulingClass(conf) or self.get_IOSchedulingPriority(conf) is not None:
+            return None
+        if self.get_OOMScoreAdjust(conf) is not None:
+            return None
+        if conf.get("Service", "StandardInput", DefaultStandardInput) in ["socket"]:
+            return None
+        workingdir = self.get_WorkingDirectory(conf)
+        if workingdir:
+            into = os_path(self._root, self.expand_special(workingdir.lstrip("-"), conf))
+        else:
+            into = self._root or os.getcwd()
+        if os.path.realpath(into) != os.path.realpath(os.getcwd()):
+            return None # there is no chdir for posix_spawn
+        inp, out, err, msg = self.journal_files_from(conf)
         if msg:
-            err.write("ERROR:")
-            err.write(msg.strip())
-            err.write("\n")
-        if EXEC_DUP2:
-            os.dup2(inp.fileno(), sys.stdin.fileno())
-            os.dup2(out.fileno(), sys.stdout.fileno())
-            os.dup2(err.fileno(), sys.stderr.fileno())
+            for fd in set([ inp, out, err ]):
+                fd.close()
+            return None # the fork will report the error (just once)
+        try:
+            actions = [ (os.POSIX_SPAWN_DUP2, inp.fileno(), 0),
+                        (os.POSIX_SPAWN_DUP2, out.fileno(), 1),
+                        (os.POSIX_SPAWN_DUP2, err.fileno(), 2) ]
+            exec_env = self.extend_exec_env(env)
+            pid = os.posix_spawn(cmd[0], cmd, exec_env, file_actions = actions, setsid = setsid)
+            logg.debug("posix_spawn PID %s", pid)
+            return pid
+        except (OSError, TypeError) as e:
+            logg.debug("(%s): no posix_spawn: %s", shell_cmd(cmd), e)
+            return None # the fork will report the error
+        finally:
+            for fd in set([ inp, out, err ]):
+                fd.close()
     def execve_from(self, conf, cmd, env):
         """ this code is commonly run in a child process // returns exit-code"""
         runs = conf.get("Service", "Type", "simple").lower()
         # logg.debug("%s process for %s => %s", runs, strE(conf.name()), strQ(conf.filename()))
+        self.cgroup_join_from(conf)
+        if self._accepted is not None:
+            self.dup2_connection(env)
         self.dup2_journal_log(conf)
+        self.exec_context_from(conf)
         #
         runuser = self.get_User(conf)
         rungroup = self.get_Group(conf)
@@ -3418,11 +5082,21 @@ class Systemctl:
                 if unit not in units:
                     units += [ unit ]
         return self.stop_units(units) and found_all
-    def stop_units(self, units):
+    def stop_units(self, units, maxjobs = None):
         """ fails if any unit fails to stop """
         self.wait_system()
         done = True
+        stopped_units = []
+        maxjobs = maxjobs or MaxParallelJobs
+        if maxjobs > 1 and len(units) > 1:
+            stopped_units = self.sortedBefore(units)
+            results = self.parallel_jobs(stopped_units, self.stop_jobs_requires(stopped_units), self.stop_unit, maxjobs)
+            for unit in stopped_units:
+                if not results.get(unit):
+                    done = False
         for unit in self.sortedBefore(units):
+            if unit in stopped_units:
+                continue
             if not self.stop_unit(unit):
                 done = False
         return done
@@ -3443,9 +5117,22 @@ class Systemctl:
     def stop_unit_from(self, conf):
         if not conf: return False
         if self.syntax_check(conf) > 100: return False
+        began = monotonic_usec()
         with waitlock(conf):
             logg.info(" stop unit %s => %s", conf.name(), strQ(conf.filename()))
-            return self.do_stop_unit_from(conf)
+            if not self._timings:
+                return self.do_stop_unit_from(conf)
+            timings = self.get_timings_from(conf)
+            done = self.do_stop_unit_from(conf)
+            for key in self.get_timings_from(conf):
+                self.set_status_from(conf, key, None)
+            for key, value in timings.items():
+                if not key.startswith("TimingStop"):
+                    self.set_status_from(conf, key, value) # the status file was cleaned
+            self.set_timing_from(conf, "StopBegin", began)
+            self.set_timing_from(conf, "StopDone")
+            self.write_status_from(conf)
+            return done
     def do_stop_unit_from(self, conf):
         if conf.name().endswith(".service"):
             return self.do_stop_service_from(conf)
@@ -3475,9 +5162,7 @@ class Systemctl:
             for cmd in conf.getlist("Service", "ExecStop", []):
                 exe, newcmd = self.exec_newcmd(cmd, env, conf)
                 logg.info("%s stop %s", runs, shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid:
-                    self.execve_from(conf, newcmd, env) # pragma: no cover
+                forkpid = self.spawn_from(conf, newcmd, env)
                 run = subprocess_waitpid(forkpid)
                 if run.returncode and exe.check: 
                     returncode = run.returncode
@@ -3505,9 +5190,7 @@ class Systemctl:
                 env["MAINPID"] = strE(self.read_mainpid_from(conf))
                 exe, newcmd = self.exec_newcmd(cmd, env, conf)
                 logg.info("%s stop %s", runs, shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid:
-                    self.execve_from(conf, newcmd, env) # pragma: no cover
+                forkpid = self.spawn_from(conf, newcmd, env)
                 run = subprocess_waitpid(forkpid)
                 run = must_have_failed(run, newcmd) # TODO: a workaround
                 # self.write_status_from(conf, MainPID=run.pid) # no ExecStop
@@ -3521,9 +5204,10 @@ class Systemctl:
                     self.clean_pid_file_from(conf)
                     self.clean_status_from(conf) # "inactive"
             else:
-                logg.info("%s sleep as no PID was found on Stop", runs)
-                time.sleep(MinimumTimeoutStopSec)
+                logg.info("%s wait as no PID was found on Stop", runs)
                 pid = self.read_mainpid_from(conf)
+                if pid: # a grace period for the ExecStop to have an effect
+                    self.wait_vanished_pids([ pid ], MinimumTimeoutStopSec)
                 if not pid or not pid_exists(pid) or pid_zombie(pid):
                     self.clean_pid_file_from(conf)
                 self.clean_status_from(conf) # "inactive"
@@ -3538,9 +5222,7 @@ class Systemctl:
                         env["MAINPID"] = strE(new_pid)
                 exe, newcmd = self.exec_newcmd(cmd, env, conf)
                 logg.info("fork stop %s", shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid:
-                    self.execve_from(conf, newcmd, env) # pragma: no cover
+                forkpid = self.spawn_from(conf, newcmd, env)
                 run = subprocess_waitpid(forkpid)
                 if run.returncode and exe.check:
                     returncode = run.returncode
@@ -3551,9 +5233,10 @@ class Systemctl:
                 if self.wait_vanished_pid(pid, timeout):
                     self.clean_pid_file_from(conf)
             else:
-                logg.info("%s sleep as no PID was found on Stop", runs)
-                time.sleep(MinimumTimeoutStopSec)
+                logg.info("%s wait as no PID was found on Stop", runs)
                 pid = self.read_mainpid_from(conf)
+                if pid: # a grace period for the ExecStop to have an effect
+                    self.wait_vanished_pids([ pid ], MinimumTimeoutStopSec)
                 if not pid or not pid_exists(pid) or pid_zombie(pid):
                     self.clean_pid_file_from(conf)
             if returncode:
@@ -3565,18 +5248,21 @@ class Systemctl:
         else:
             logg.error("unsupported run type '%s'", runs)
             return False
+        if not returncode and self.cgroup_pids_from(conf):
+            if self.get_KillMode(conf) in [ "control-group", "mixed" ]:
+                logg.info("stop the remaining processes in the cgroup of %s", conf.name())
+                self.do_kill_unit_from(conf)
         # POST sequence
         if not self.is_active_from(conf):
             env["SERVICE_RESULT"] = service_result
             for cmd in conf.getlist("Service", "ExecStopPost", []):
                 exe, newcmd = self.exec_newcmd(cmd, env, conf)
                 logg.info("post-stop %s", shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid:
-                    self.execve_from(conf, newcmd, env) # pragma: no cover
+                forkpid = self.spawn_from(conf, newcmd, env)
                 run = subprocess_waitpid(forkpid)
                 logg.debug("post-stop done (%s) <-%s>", 
                     run.returncode or "OK", run.signal or "")
+        self.cgroup_remove_from(conf)
         if _what_kind not in ["none", "keep"]:
             self.remove_service_directories(conf)
         return service_result == "success"
@@ -3598,6 +5284,16 @@ class Systemctl:
             # we do not listen but have the service started right away
             done = self.do_stop_service_from(service_conf)
             service_result = done and "success" or "failed"
+        elif self.is_socket_accept_instances(conf):
+            sock = self._sockets.get(conf.name())
+            for instance, (_, instance_conf) in (sock and list(sock.connections.items()) or []):
+                pid = self.read_mainpid_from(instance_conf)
+                if not pid: continue
+                logg.info("%s: stop connection %s [%s]", conf.name(), instance, pid)
+                try: os.kill(pid, signal.SIGTERM)
+                except OSError as e: logg.debug("%s: stop connection [%s]: %s", conf.name(), pid, e)
+            self.clean_status_from(conf)
+            service_result = "success"
         else:
             done = self.do_stop_service_from(service_conf)
             service_result = done and "success" or "failed"
@@ -3609,9 +5305,7 @@ class Systemctl:
             for cmd in conf.getlist("Socket", "ExecStopPost", []):
                 exe, newcmd = self.exec_newcmd(cmd, env, conf)
                 logg.info("post-stop %s", shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid:
-                    self.execve_from(conf, newcmd, env) # pragma: no cover
+                forkpid = self.spawn_from(conf, newcmd, env)
                 run = subprocess_waitpid(forkpid)
                 logg.debug("post-stop done (%s) <-%s>", 
                     run.returncode or "OK", run.signal or "")
@@ -3622,13 +5316,49 @@ class Systemctl:
         if not self.is_active_pid(pid):
             return True
         logg.info("wait for PID %s to vanish (%ss)", pid, timeout)
-        for x in xrange(int(timeout)):
-            time.sleep(1) # until TimeoutStopSec
-            if not self.is_active_pid(pid):
-                logg.info("wait for PID %s is done (%s.)", pid, x)
-                return True
+        started = time.time()
+        if self.wait_vanished_pids([ pid ], timeout):
+            logg.info("wait for PID %s is done (%s.)", pid, int(time.time() - started))
+            return True
         logg.info("wait for PID %s failed (%s.)", pid, timeout)
         return False
+    def wait_vanished_pids(self, pids, timeout):
+        """ block on a pidfd of each process until all have exited (zombies are
+            gone as well) - or check them in growing intervals on older systems """
+        deadline = time.time() + timeout # until TimeoutStopSec
+        pidfds = {}
+        poller = select.poll()
+        backoff = 0.01 # seconds, doubled up to 1.0
+        try:
+            for pid in pids:
+                pidfd = pid_open(pid)
+                if pidfd is not None:
+                    pidfds[pidfd] = pid
+                    poller.register(pidfd, select.POLLIN)
+            while True:
+                alive = [ pid for pid in pids if self.is_active_pid(pid) ]
+                if not alive:
+                    return True
+                now = time.time()
+                if now >= deadline:
+                    return False
+                wait_secs = deadline - now
+                if [ pid for pid in alive if pid not in pidfds.values() ]:
+                    wait_secs = min(wait_secs, backoff)
+                    backoff = min(backoff * 2, 1.0)
+                try:
+                    events = poller.poll(int(wait_secs * 1000) + 1)
+                except (select.error, OSError) as e:
+                    if e.args and e.args[0] == errno.EINTR:
+                        continue
+                    raise
+                for fd, event in events:
+                    poller.unregister(fd)
+                    os.close(fd)
+                    del pidfds[fd]
+        finally:
+            for pidfd in pidfds:
+                os.close(pidfd)
     def reload_modules(self, *modules):
         """ [UNIT]... -- reload these units """
         self.wait_system()
@@ -3697,9 +5427,7 @@ class Systemctl:
                 newcmd = [initscript, "reload"]
                 env["SYSTEMCTL_SKIP_REDIRECT"] = "yes"
                 logg.info("%s reload %s", runs, shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid:
-                    self.execve_from(conf, newcmd, env) # pragma: nocover
+                forkpid = self.spawn_from(conf, newcmd, env)
                 run = subprocess_waitpid(forkpid)
                 self.set_status_from(conf, "ExecReloadCode", run.returncode)
                 if run.returncode:
@@ -3718,9 +5446,7 @@ class Systemctl:
                 env["MAINPID"] = strE(self.read_mainpid_from(conf))
                 exe, newcmd = self.exec_newcmd(cmd, env, conf)
                 logg.info("%s reload %s", runs, shell_cmd(newcmd))
-                forkpid = os.fork()
-                if not forkpid:
-                    self.execve_from(conf, newcmd, env) # pragma: no cover
+                forkpid = self.spawn_from(conf, newcmd, env)
                 run = subprocess_waitpid(forkpid)
                 if run.returncode and exe.check: 
                     logg.error("Job for %s failed because the control process exited with error code. (%s)", 
@@ -3773,7 +5499,10 @@ class Systemctl:
             if conf.name().endswith(".service"):
                 logg.info(" restart service %s => %s", conf.name(), strQ(conf.filename()))
                 if not self.is_active_from(conf):
-                    return self.do_start_unit_from(conf)
+                    began = monotonic_usec()
+                    done = self.do_start_unit_from(conf)
+                    self.note_start_seconds(conf.name(), (monotonic_usec() - began) / 1000000.)
+                    return done
                 else:
                     return self.do_restart_unit_from(conf)
             else:
@@ -3781,7 +5510,10 @@ class Systemctl:
     def do_restart_unit_from(self, conf):
         logg.info("(restart) => stop/start %s", conf.name())
         self.do_stop_unit_from(conf)
-        return self.do_start_unit_from(conf)
+        began = monotonic_usec()
+        done = self.do_start_unit_from(conf)
+        self.note_start_seconds(conf.name(), (monotonic_usec() - began) / 1000000.)
+        return done
     def try_restart_modules(self, *modules):
         """ [UNIT]... -- try-restart these units """
         found_all = True
@@ -3961,20 +5693,24 @@ class Systemctl:
         size = os.path.exists(status_file) and os.path.getsize(status_file)
         logg.info("STATUS %s %s", status_file, size)
         mainpid = self.read_mainpid_from(conf)
+        cgroup_pids = self.cgroup_pids_from(conf) # all processes of the unit
         self.clean_status_from(conf) # clear RemainAfterExit and TimeoutStartSec
-        if not mainpid:
+        if not mainpid and not cgroup_pids:
             if useKillMode in ["control-group"]:
                 logg.warning("no main PID %s", strQ(conf.filename()))
                 logg.warning("and there is no control-group here")
             else:
                 logg.info("no main PID %s", strQ(conf.filename()))
+            self.cgroup_remove_from(conf)
             return False
-        if not pid_exists(mainpid) or pid_zombie(mainpid):
+        proctable = ProcTable()
+        if not cgroup_pids and (not proctable.exists(mainpid) or proctable.zombie(mainpid)):
             logg.debug("ignoring children when mainpid is already dead")
             # because we list child processes, not processes in control-group
+            self.cgroup_remove_from(conf)
             return True
-        pidlist = self.pidlist_of(mainpid) # here
-        if pid_exists(mainpid):
+        pidlist = cgroup_pids or self.pidlist_of(mainpid, proctable) # here
+        if mainpid and pid_exists(mainpid):
             logg.info("stop kill PID %s", mainpid)
             self._kill_pid(mainpid, kill_signal)
         if useKillMode in ["control-group"]:
@@ -3988,34 +5724,35 @@ class Systemctl:
             for pid in pidlist:
                 self._kill_pid(pid, signal.SIGHUP)
         # wait for the processes to have exited
-        while True:
-            dead = True
-            for pid in pidlist:
-                if pid_exists(pid) and not pid_zombie(pid):
-                    dead = False
-                    break
-            if dead:
-                break
-            if time.time() > started + timeout:
-                logg.info("service PIDs not stopped after %s", timeout)
-                break
-            time.sleep(1) # until TimeoutStopSec
+        dead = self.wait_vanished_pids(pidlist, started + timeout - time.time())
+        if dead and cgroup_pids and useKillMode in ["control-group"]:
+            pidlist = self.cgroup_pids_from(conf) # forked in the meantime
+            dead = not pidlist
+        if not dead:
+            logg.info("service PIDs not stopped after %s", timeout)
         if dead or not doSendSIGKILL:
             logg.info("done kill PID %s %s", mainpid, dead and "OK")
+            if dead:
+                self.cgroup_remove_from(conf)
             return dead
         if useKillMode in [ "control-group", "mixed" ]:
             logg.info("hard kill PIDs %s", pidlist)
-            for pid in pidlist:
-                if pid != mainpid:
-                    self._kill_pid(pid, signal.SIGKILL)
-            time.sleep(MinimumYield)
+            if cgroup_pids and self.cgroup_kill_from(conf):
+                pidlist = self.cgroup_pids_from(conf) or pidlist
+            else:
+                for pid in pidlist:
+                    if pid != mainpid:
+                        self._kill_pid(pid, signal.SIGKILL)
+            self.wait_vanished_pids([ pid for pid in pidlist if pid != mainpid ], MinimumYield)
         # useKillMode in [ "control-group", "mixed", "process" ]
-        if pid_exists(mainpid):
+        if mainpid and pid_exists(mainpid):
             logg.info("hard kill PID %s", mainpid)
             self._kill_pid(mainpid, signal.SIGKILL)
-            time.sleep(MinimumYield)
-        dead = not pid_exists(mainpid) or pid_zombie(mainpid)
+            self.wait_vanished_pids([ mainpid ], MinimumYield)
+        dead = not mainpid or not pid_exists(mainpid) or pid_zombie(mainpid)
         logg.info("done hard kill PID %s %s", mainpid, dead and "OK")
+        if dead:
+            self.cgroup_remove_from(conf)
         return dead
     def _kill_pid(self, pid, kill_signal = None):
         try: 
@@ -4029,6 +5766,141 @@ class Systemctl:
                 logg.error("kill PID %s => %s", pid, str(e))
                 return False
         return not pid_exists(pid) or pid_zombie(pid)
+    def init_cgroups(self):
+        """ the PID-1 starts each service in a child cgroup of its own cgroup. That
+            needs a writable cgroup2 mount - and for the resource limits of the units
+            the PID-1 moves itself into an init.scope (no processes in inner nodes) """
+        if self._cgroup_base is not None:
+            return self._cgroup_base
+        self._cgroup_base = ""
+        if not CGROUP_TRACKING:
+            return ""
+        if not os.path.isfile(os.path.join(_cgroup_folder, "cgroup.controllers")):
+            logg.debug("no cgroup2 on %s", _cgroup_folder)
+            return ""
+        own = "/"
+        try:
+            for line in open(_proc_self_cgroup):
+                if line.startswith("0::"):
+                    own = line[3:].strip()
+        except (OSError, IOError) as e:
+            logg.debug("no cgroup of PID-1: %s", e)
+        base = os.path.join(_cgroup_folder, own.lstrip("/")).rstrip("/")
+        if not os.access(os.path.join(base, "cgroup.procs"), os.W_OK):
+            logg.debug("no writable cgroup %s", base)
+            return ""
+        controllers = [ name for name in self.cgroup_read(base, "cgroup.controllers").split() if name in [ "cpu", "memory", "pids" ] ]
+        if controllers:
+            subtree = " ".join([ "+" + name for name in controllers ])
+            if not self.cgroup_write(base, "cgroup.subtree_control", subtree, quiet = True):
+                scope = os.path.join(base, "init.scope")
+                try:
+                    if not os.path.isdir(scope):
+                        os.mkdir(scope)
+                    for pid in self.cgroup_read(base, "cgroup.procs").split():
+                        self.cgroup_write(scope, "cgroup.procs", pid, quiet = True)
+                except OSError as e:
+                    logg.debug("no %s: %s", scope, e)
+                if not self.cgroup_write(base, "cgroup.subtree_control", subtree):
+                    logg.info("no resource control for the units in %s", base)
+        cgroup_base_file = os_path(self._root, expand_path(_cgroup_base_file, not self.user_mode()))
+        try:
+            if not os.path.isdir(os.path.dirname(cgroup_base_file)):
+                os.makedirs(os.path.dirname(cgroup_base_file))
+            f = open(cgroup_base_file, "w")
+            f.write(base + "\n")
+            f.close()
+        except (OSError, IOError) as e:
+            logg.warning("can not write %s: %s", cgroup_base_file, e)
+        logg.info("cgroup tracking in %s", base)
+        self._cgroup_base = base
+        return base
+    def done_cgroups(self):
+        cgroup_base_file = os_path(self._root, expand_path(_cgroup_base_file, not self.user_mode()))
+        if self._cgroup_base and os.path.exists(cgroup_base_file):
+            os.remove(cgroup_base_file)
+    def cgroup_base(self):
+        """ the folder of the unit cgroups - as set up by the PID-1 """
+        if self._cgroup_base is None:
+            self._cgroup_base = ""
+            cgroup_base_file = os_path(self._root, expand_path(_cgroup_base_file, not self.user_mode()))
+            if CGROUP_TRACKING and os.path.isfile(cgroup_base_file): # written by the PID-1
+                base = open(cgroup_base_file).read().strip()
+                if os.access(os.path.join(base, "cgroup.procs"), os.W_OK):
+                    self._cgroup_base = base
+        return self._cgroup_base
+    def cgroup_from(self, conf): # -> path?
+        base = self.cgroup_base()
+        if not base:
+            return None
+        return os.path.join(base, conf.name())
+    def cgroup_read(self, cgroup, name):
+        try:
+            f = open(os.path.join(cgroup, name))
+            text = f.read()
+            f.close()
+            return text
+        except (OSError, IOError) as e:
+            logg.debug("can not read %s/%s: %s", cgroup, name, e)
+            return ""
+    def cgroup_write(self, cgroup, name, value, quiet = False):
+        try:
+            f = open(os.path.join(cgroup, name), "w")
+            f.write(value)
+            f.close()
+            return True
+        except (OSError, IOError) as e:
+            if quiet:
+                logg.debug("can not write %s to %s/%s: %s", value, cgroup, name, e)
+            else:
+                logg.warning("can not write %s to %s/%s: %s", value, cgroup, name, e)
+            return False
+    def cgroup_create_from(self, conf):
+        """ a child cgroup for the unit processes - with its MemoryMax, CPUQuota, TasksMax """
+        cgroup = self.cgroup_from(conf)
+        if not cgroup:
+            return None
+        try:
+            if not os.path.isdir(cgroup):
+                os.mkdir(cgroup)
+        except OSError as e:
+            logg.warning("can not create cgroup %s: %s", cgroup, e)
+            return None
+        for name, value in [ ("memory.max", self.get_MemoryMax(conf)), ("cpu.max", self.get_CPUQuota(conf)),
+                             ("pids.max", self.get_TasksMax(conf)) ]:
+            if value is None:
+                continue
+            if not os.path.exists(os.path.join(cgroup, name)):
+                logg.warning("%s: no %s controller for %s", conf.name(), name.split(".")[0], name)
+                continue
+            if self.cgroup_write(cgroup, name, value):
+                logg.debug("%s: %s=%s", conf.name(), name, value)
+        return cgroup
+    def cgroup_join_from(self, conf):
+        """ done in the forked process before its exec """
+        cgroup = self.cgroup_from(conf)
+        if cgroup and os.path.isdir(cgroup):
+            self.cgroup_write(cgroup, "cgroup.procs", str(os.getpid()))
+    def cgroup_pids_from(self, conf):
+        """ the processes of the unit in one read (an empty list when not tracked) """
+        cgroup = self.cgroup_from(conf)
+        if not cgroup or not os.path.isdir(cgroup):
+            return []
+        return [ int(pid) for pid in self.cgroup_read(cgroup, "cgroup.procs").split() ]
+    def cgroup_kill_from(self, conf):
+        """ SIGKILL to all processes of the unit (since Linux 5.14) """
+        cgroup = self.cgroup_from(conf)
+        if not cgroup or not os.path.exists(os.path.join(cgroup, "cgroup.kill")):
+            return False
+        logg.info("hard kill cgroup %s", cgroup)
+        return self.cgroup_write(cgroup, "cgroup.kill", "1")
+    def cgroup_remove_from(self, conf):
+        cgroup = self.cgroup_from(conf)
+        if cgroup and os.path.isdir(cgroup):
+            try:
+                os.rmdir(cgroup)
+            except OSError as e:
+                logg.debug("can not remove cgroup %s: %s", cgroup, e) # still some processes
     def is_active_modules(self, *modules):
         """ [UNIT].. -- check if these units are in active state
         implements True if all is-active = True """
@@ -4081,9 +5953,14 @@ class Systemctl:
         return self.is_active_pid(pid)
     def is_active_pid(self, pid):
         """ returns pid if the pid is still an active process """
-        if pid and pid_exists(pid) and not pid_zombie(pid):
+        if pid and self.pid_alive(pid):
             return pid # usually a string (not null)
         return None
+    def pid_alive(self, pid):
+        """ pid_exists and not pid_zombie - from the /proc snapshot of batchstates """
+        if self._proc_snapshot is not None:
+            return self._proc_snapshot.alive(int(pid))
+        return pid_exists(pid) and not pid_zombie(pid)
     def get_active_unit(self, unit):
         """ returns 'active' 'inactive' 'failed' 'unknown' """
         conf = self.load_unit_conf(unit)
@@ -4096,6 +5973,8 @@ class Systemctl:
         if conf.name().endswith(".service"):
             return self.get_active_service_from(conf)
         elif conf.name().endswith(".socket"):
+            if self.is_socket_accept_instances(conf):
+                return self.read_status_from(conf).get("ActiveState", "inactive")
             service_unit = self.get_socket_service_from(conf)
             service_conf = self.load_unit_conf(service_unit)
             return self.get_active_service_from(service_conf)
@@ -4123,7 +6002,9 @@ class Systemctl:
         if DEBUG_STATUS:
             logg.debug("pid_file '%s' => PID %s", pid_file or status_file, strE(pid))
         if pid:
-            if not pid_exists(pid) or pid_zombie(pid):
+            if not self.pid_alive(pid):
+                if conf.get("Service", "Type", "simple").lower() == "forking" and self.cgroup_pids_from(conf):
+                    return "active" # the daemon did fork away from its MAINPID
                 return "failed"
             return "active"
         else:
@@ -4175,7 +6056,7 @@ class Systemctl:
         if DEBUG_STATUS:
             logg.debug("pid_file '%s' => PID %s", pid_file or status_file, strE(pid))
         if pid:
-            if not pid_exists(pid) or pid_zombie(pid):
+            if not self.pid_alive(pid):
                 return "failed"
             return "running"
         else:
@@ -4280,11 +6161,12 @@ class Systemctl:
             and the last non-successful statuscode """
         status = 0 
         result = ""
-        for unit in units:
-            status1, result1 = self.status_unit(unit)
-            if status1: status = status1
-            if result: result += "\n\n"
-            result += result1
+        with batchstates(self):
+            for unit in units:
+                status1, result1 = self.status_unit(unit)
+                if status1: status = status1
+                if result: result += "\n\n"
+                result += result1
         if status:
             self.error |= NOT_OK | NOT_ACTIVE # 3 
         return result
@@ -4869,7 +6751,7 @@ class Systemctl:
         for line in self.list_dependencies(unit, ""):
             result += [ line ]
         return result
-    def list_dependencies(self, unit, indent = None, mark = None, loop = []):
+    def list_dependencies(self, unit, indent = None, mark = None, loop = None):
         mapping = {}
         mapping["Requires"] = "required to start"
         mapping["Wants"] = "wanted to start"
@@ -4884,6 +6766,7 @@ class Systemctl:
             "BindsTo", ".requires", ".wants"]
         indent = indent or ""
         mark = mark or ""
+        loop = loop or []
         deps = self.get_dependencies_unit(unit)
         conf = self.get_unit_conf(unit)
         if not conf.loaded():
@@ -4914,6 +6797,9 @@ class Systemctl:
     def get_dependencies_unit(self, unit, styles = None):
         styles = styles or [ "Requires", "Wants", "Requisite", "BindsTo", "PartOf", "ConsistsOf",
             ".requires", ".wants", "PropagateReloadTo", "Conflicts",  ]
+        cached = self._dependencies.get((unit, tuple(styles)))
+        if cached is not None:
+            return cached
         conf = self.get_unit_conf(unit)
         deps = {}
         for style in styles:
@@ -4932,6 +6818,7 @@ class Systemctl:
                 for requirelist in conf.getlist("Unit", style, []):
                     for required in requirelist.strip().split(" "):
                         deps[required.strip()] = style
+        self._dependencies[(unit, tuple(styles))] = deps
         return deps
     def get_required_dependencies(self, unit, styles = None):
         styles = styles or [ "Requires", "Wants", "Requisite", "BindsTo",
@@ -4941,23 +6828,25 @@ class Systemctl:
         """ the list of services to be started as well / TODO: unused """
         styles = styles or ["Requires", "Wants", "Requisite", "BindsTo", "PartOf", "ConsistsOf",
             ".requires", ".wants"]
+        cached = self._dependencies_closure.get((unit, tuple(styles)))
+        if cached is not None:
+            return cached
         deps = {}
-        unit_deps = self.get_dependencies_unit(unit)
-        for dep_unit, dep_style in unit_deps.items():
-            if dep_style in styles:
-                if dep_unit in deps:
-                    if dep_style not in deps[dep_unit]:
-                        deps[dep_unit].append( dep_style)
-                else:
-                    deps[dep_unit] = [ dep_style ]
-                next_deps = self.get_start_dependencies(dep_unit)
-                for dep, styles in next_deps.items():
-                    for style in styles:
-                        if dep in deps:
-                            if style not in deps[dep]:
-                                deps[dep].append(style)
-                        else:
-                            deps[dep] = [ style ]
+        todo = [ unit ]
+        seen = set(todo)
+        while todo:
+            next_unit = todo.pop(0)
+            for dep_unit, dep_style in self.get_dependencies_unit(next_unit).items():
+                if dep_style not in styles or dep_unit == unit:
+                    continue
+                if dep_unit not in deps:
+                    deps[dep_unit] = []
+                if dep_style not in deps[dep_unit]:
+                    deps[dep_unit].append(dep_style)
+                if dep_unit not in seen:
+                    seen.add(dep_unit)
+                    todo.append(dep_unit)
+        self._dependencies_closure[(unit, tuple(styles))] = deps
         return deps
     def list_start_dependencies_units(self, units):
         unit_order = []
@@ -4987,11 +6876,100 @@ class Systemctl:
             if conf.loaded():
                 deps_conf.append(conf)
         result = []
-        sortlist = conf_sortedAfter(deps_conf, cmp=compareAfter)
+        sortlist = conf_sortedAfter(deps_conf)
         for item in sortlist:
             line = (item.name(),  "(%s)" % (" ".join(deps[item.name()])))
             result.append(line)
         return result
+    def analyze_modules(self, *modules):
+        """ [blame|critical-chain] [UNIT]... show the start phases that
+            were recorded in the status files (see --timings)
+        """
+        command = modules and modules[0] or "blame"
+        units = self.match_units(to_list(modules[1:]))
+        timings = collections.OrderedDict()
+        with batchstates(self):
+            for unit in units:
+                conf = self.load_unit_conf(unit)
+                if conf is None:
+                    continue
+                found = self.get_timings_from(conf)
+                if found:
+                    timings[unit] = found
+        if command in [ "blame" ]:
+            return self.analyze_blame(timings)
+        if command in [ "critical-chain" ]:
+            return self.analyze_critical_chain(timings, list(modules[1:]))
+        logg.error("Unknown analyze %s (use blame or critical-chain)", command)
+        return False
+    def analyze_blame(self, timings):
+        """ the units sorted by the time they took to start - along
+            with the phases that did take longer than a millisecond """
+        phases = [ ("lock", "StartBegin", "StartLocked"), ("pre", "StartPre", "StartExec"),
+                   ("", "StartExec", "StartReady"), ("post", "StartPost", "StartDone"),
+                   ("stop", "StopBegin", "StopDone") ]
+        found = []
+        for unit, timing in timings.items():
+            took = timing_span(timing, "StartBegin", "StartDone")
+            if took is None:
+                continue
+            details = []
+            for name, begin, end in phases:
+                span = timing_span(timing, begin, end)
+                if span and span >= 1000:
+                    name = name or timing.get("TimingStartWait", "exec")
+                    details.append("%s %s" % (name, usec_to_time(span)))
+            found.append((took, unit, details))
+        result = []
+        for took, unit, details in sorted(found, key = lambda item: item[0], reverse = True):
+            line = "%10s %s" % (usec_to_time(took), unit)
+            if details:
+                line += " (%s)" % ", ".join(details)
+            result.append(line)
+        return result
+    def analyze_critical_chain(self, timings, units):
+        """ the After= chain of the units that were waited for - by default it
+            is shown for the unit that was the last to become active """
+        began = [ to_intN(timing.get("TimingStartBegin")) for timing in timings.values() ]
+        began = [ usec for usec in began if usec is not None ]
+        if not began:
+            logg.error("no start phases recorded (use --timings)")
+            return False
+        if not units:
+            done = [ (to_intN(timing.get("TimingStartDone")) or 0, unit) for unit, timing in timings.items() ]
+            units = [ max(done)[1] ]
+        result = [ "The time when unit became active or started is printed after the \"@\" character.",
+                   "The time the unit took to start is printed after the \"+\" character.", "" ]
+        for unit in units:
+            result += self.critical_chain(unit, timings, min(began))
+        return result
+    def critical_chain(self, unit, timings, base, indent = "", loop = None):
+        loop = (loop or []) + [ unit ]
+        timing = timings.get(unit, {})
+        line = indent + unit
+        done = to_intN(timing.get("TimingStartDone"))
+        if done is not None:
+            line += " @%s" % usec_to_time(done - base)
+        took = timing_span(timing, "StartBegin", "StartDone")
+        if took:
+            line += " +%s" % usec_to_time(took)
+        result = [ line ]
+        conf = self.load_unit_conf(unit)
+        if conf is None:
+            return result
+        started = to_intN(timing.get("TimingStartBegin"))
+        latest = None
+        for after in getAfter(conf):
+            if after in loop:
+                continue
+            ready = to_intN(timings.get(after, {}).get("TimingStartDone"))
+            if ready is None or (started is not None and ready > started):
+                continue
+            if latest is None or ready > latest[0]:
+                latest = (ready, after)
+        if latest:
+            result += self.critical_chain(latest[1], timings, base, indent + "| ", loop)
+        return result
     def sortedAfter(self, unitlist):
         """ get correct start order for the unit list (ignoring masked units) """
         conflist = [ self.get_unit_conf(unit) for unit in unitlist ]
@@ -5045,6 +7023,7 @@ class Systemctl:
             errors += self.syntax_check(conf)
         if errors:
             logg.warning(" (%s) found %s problems", errors, errors % 100)
+        self.write_unit_cache()
         return True # errors
     def syntax_check(self, conf):
         filename = conf.filename()
@@ -5276,6 +7255,15 @@ class Systemctl:
         yield "User", self.get_User(conf) or ""
         yield "Group", self.get_Group(conf) or ""
         yield "SupplementaryGroups", " ".join(self.get_SupplementaryGroups(conf))
+        for name, soft, hard in self.get_Limits(conf):
+            yield name, hard == resource.RLIM_INFINITY and "infinity" or str(hard)
+            yield name + "Soft", soft == resource.RLIM_INFINITY and "infinity" or str(soft)
+        yield "Nice", str(self.get_Nice(conf) or 0)
+        yield "CPUAffinity", " ".join([ str(cpu) for cpu in self.get_CPUAffinity(conf) ])
+        yield "IOSchedulingClass", self.get_IOSchedulingClass(conf) or ""
+        level = self.get_IOSchedulingPriority(conf)
+        yield "IOSchedulingPriority", "" if level is None else str(level)
+        yield "OOMScoreAdjust", str(self.get_OOMScoreAdjust(conf) or 0)
         yield "TimeoutStartUSec", seconds_to_time(self.get_TimeoutStartSec(conf))
         yield "TimeoutStopUSec", seconds_to_time(self.get_TimeoutStopSec(conf))
         yield "NeedDaemonReload", "no"
@@ -5283,9 +7271,21 @@ class Systemctl:
         yield "SendSIGHUP", strYes(self.get_SendSIGHUP(conf))
         yield "KillMode", strE(self.get_KillMode(conf))
         yield "KillSignal", strE(self.get_KillSignal(conf))
+        cgroup = self.cgroup_from(conf)
+        if cgroup and os.path.isdir(cgroup):
+            yield "ControlGroup", cgroup.startswith(_cgroup_folder + "/") and cgroup[len(_cgroup_folder):] or cgroup
+        memory_max = self.get_MemoryMax(conf)
+        yield "MemoryMax", memory_max not in [ None, "max" ] and memory_max or "infinity"
+        cpu_max = self.get_CPUQuota(conf)
+        yield "CPUQuotaPerSecUSec", cpu_max and seconds_to_time(int(cpu_max.split()[0]) / 100000.) or "infinity"
+        tasks_max = self.get_TasksMax(conf)
+        yield "TasksMax", tasks_max not in [ None, "max" ] and tasks_max or "infinity"
         yield "StartLimitBurst", strE(self.get_StartLimitBurst(conf))
         yield "StartLimitIntervalSec", seconds_to_time(self.get_StartLimitIntervalSec(conf))
         yield "RestartSec", seconds_to_time(self.get_RestartSec(conf))
+        yield "RestartSteps", strE(self.get_RestartSteps(conf))
+        restart_max_delay = self.get_RestartMaxDelaySec(conf)
+        yield "RestartMaxDelaySec", restart_max_delay is not None and seconds_to_time(restart_max_delay) or "infinity"
         yield "RemainAfterExit", strYes(self.get_RemainAfterExit(conf))
         yield "WorkingDirectory", strE(self.get_WorkingDirectory(conf))
         env_parts = []
@@ -5306,6 +7306,47 @@ class Systemctl:
         return conf.get("Service", "KillMode", "control-group")
     def get_KillSignal(self, conf):
         return conf.get("Service", "KillSignal", "SIGTERM")
+    def get_MemoryMax(self, conf): # -> memory.max?
+        value = conf.get("Service", "MemoryMax", "").strip()
+        if not value:
+            return None
+        if value == "infinity":
+            return "max"
+        if value.endswith("%"):
+            total = 0
+            for line in open("/proc/meminfo"):
+                if line.startswith("MemTotal:"):
+                    total = int(line.split()[1]) * 1024
+            return str(int(total * float(value[:-1]) / 100))
+        size = size_to_bytes(value)
+        if size is None:
+            logg.error(" %s: bad MemoryMax=%s", conf.name(), value)
+            return None
+        return str(size)
+    def get_CPUQuota(self, conf): # -> cpu.max?
+        value = conf.get("Service", "CPUQuota", "").strip()
+        if not value:
+            return None
+        try:
+            percent = float(value.rstrip("%"))
+        except ValueError:
+            logg.error(" %s: bad CPUQuota=%s", conf.name(), value)
+            return None
+        return "%i 100000" % int(percent * 1000) # per 100ms
+    def get_TasksMax(self, conf): # -> pids.max?
+        value = conf.get("Service", "TasksMax", "").strip()
+        if not value:
+            return None
+        if value == "infinity":
+            return "max"
+        try:
+            if value.endswith("%"):
+                pid_max = int(open("/proc/sys/kernel/pid_max").read())
+                return str(int(pid_max * float(value[:-1]) / 100))
+            return str(int(value))
+        except ValueError:
+            logg.error(" %s: bad TasksMax=%s", conf.name(), value)
+            return None
     #
     igno_centos = [ "netconsole", "network" ]
     igno_opensuse = [ "raw", "pppoe", "*.local", "boot.*", "rpmconf*", "postfix*" ]
@@ -5554,11 +7595,18 @@ class Systemctl:
             logg.info("init-loop start")
             sig = self.init_loop_until_stop(services)
             logg.info("init-loop %s", sig)
-            self.stop_system_default()
+            self.stop_system_default(init)
+            if self._log_tee:
+                self.stop_journal_pipes(services)
+            self.done_cgroups()
         return not not services
     def start_target_system(self, target, init = False):
         services = self.target_default_services(target, "S")
         self.sysinit_status(SubState = "starting")
+        if init:
+            self.init_cgroups()
+        if init and JOURNAL_PIPES:
+            self.start_journal_pipes(services)
         self.start_units(services)
         return services
     def do_start_target_from(self, conf):
@@ -5568,18 +7616,21 @@ class Systemctl:
         units = [service for service in services if not self.is_running_unit(service)]
         logg.debug("start %s is starting %s from %s", target, units, services)
         return self.start_units(units)
-    def stop_system_default(self):
+    def stop_system_default(self, init = False):
         """ detect the default.target services and stop them.
             This is commonly run through 'systemctl halt' or
             at the end of a 'systemctl --init default' loop."""
         target = self.get_default_target()
-        services = self.stop_target_system(target)
+        services = self.stop_target_system(target, init)
         logg.info("%s system is down", target)
         return not not services
-    def stop_target_system(self, target):
+    def stop_target_system(self, target, init = False):
         services = self.target_default_services(target, "K")
         self.sysinit_status(SubState = "stopping")
-        self.stop_units(services)
+        if init:
+            self.stop_units(services, max(MaxParallelJobs, InitStopParallelJobs))
+        else:
+            self.stop_units(services)
         return services
     def do_stop_target_from(self, conf):
         target = conf.name()
@@ -5692,10 +7743,59 @@ class Systemctl:
         done = self.start_units(units, init = True) 
         logg.info("-- init is done")
         return done # and found_all
+    def start_journal_pipes(self, units):
+        """ create the fifos before the units are started - the output is written
+            to stdout and the journal log file (which rotates at JournalLogMaxSize) """
+        for unit in units:
+            conf = self.load_unit_conf(unit)
+            if not conf: continue
+            if self.skip_journal_log(conf): continue
+            pipe_file = self.get_journal_pipe_from(conf)
+            log_file = self.get_journal_log_from(conf)
+            try:
+                for folder in [ os.path.dirname(pipe_file), os.path.dirname(log_file) ]:
+                    if not os.path.isdir(folder):
+                        os.makedirs(folder)
+                if os.path.exists(pipe_file):
+                    os.remove(pipe_file)
+                os.mkfifo(pipe_file, 0o600)
+                piped = os.open(pipe_file, os.O_RDWR | os.O_NONBLOCK) # never gets EOF
+                logged = os.open(log_file, os.O_WRONLY | os.O_APPEND | os.O_CREAT, 0o644)
+            except Exception as e:
+                logg.error("can not create %s pipe: %s\n\t%s", unit, pipe_file, e)
+                continue
+            for fd in [ piped, logged ]:
+                fcntl.fcntl(fd, fcntl.F_SETFD, fcntl.fcntl(fd, fcntl.F_GETFD) | fcntl.FD_CLOEXEC)
+            self._log_file[unit] = piped
+            self._log_hold[unit] = b""
+            self._log_tee[unit] = logged
+            st = os.fstat(logged)
+            if st.st_size:
+                self.index_journal_log(unit, st.st_size, st.st_mtime) # the old lines
+    def tee_journal_log(self, unit, content):
+        """ append to the journal log for a fifo and rotate it at JournalLogMaxSize """
+        logged = self._log_tee[unit]
+        self.index_journal_log(unit, os.fstat(logged).st_size)
+        os.write(logged, content)
+        if os.fstat(logged).st_size < JournalLogMaxSize:
+            return
+        conf = self.load_unit_conf(unit)
+        if conf is None:
+            return
+        log_file = self.get_journal_log_from(conf)
+        try:
+            os.rename(log_file, log_file + ".1")
+            self.stop_journal_index(unit, remove = True)
+            self._log_tee[unit] = os.open(log_file, os.O_WRONLY | os.O_APPEND | os.O_CREAT, 0o644)
+            fcntl.fcntl(self._log_tee[unit], fcntl.F_SETFD, fcntl.FD_CLOEXEC)
+            os.close(logged)
+            logg.debug("rotated %s journal log %s", unit, log_file)
+        except OSError as e:
+            logg.warning("can not rotate %s: %s", log_file, e)
     def start_log_files(self, units):
-        self._log_file = {}
-        self._log_hold = {}
         for unit in units:
+            if unit in self._log_file:
+                continue # see start_journal_pipes
             conf = self.load_unit_conf(unit)
             if not conf: continue
             if self.skip_journal_log(conf): continue
@@ -5704,40 +7804,120 @@ class Systemctl:
                 opened = os.open(log_path, os.O_RDONLY | os.O_NONBLOCK)
                 self._log_file[unit] = opened
                 self._log_hold[unit] = b""
+                st = os.fstat(opened)
+                if st.st_size:
+                    self.index_journal_log(unit, st.st_size, st.st_mtime) # the old lines
             except Exception as e:
                 logg.error("can not open %s log: %s\n\t%s", unit, log_path, e)
     def read_log_files(self, units):
-        BUFSIZE=8192
+        """ forward the new lines in the journal logs to stdout - each unit's
+            chunk of lines is prefixed and written in one go (without fsync) """
+        BUFSIZE=65536
         for unit in units:
             if unit in self._log_file:
-                new_text = b""
+                chunks = [ self._log_hold[unit] ]
                 while True:
-                    buf = os.read(self._log_file[unit], BUFSIZE)
+                    try:
+                        buf = os.read(self._log_file[unit], BUFSIZE)
+                    except OSError as e:
+                        if e.errno not in [ errno.EAGAIN, errno.EWOULDBLOCK, errno.EINTR ]:
+                            raise
+                        break
                     if not buf: break
-                    new_text += buf
-                    continue
-                text = self._log_hold[unit] + new_text
+                    chunks.append(buf)
+                text = b"".join(chunks)
                 if not text: continue
                 lines = text.split(b"\n")
-                if not text.endswith(b"\n"):
-                    self._log_hold[unit] = lines[-1]
-                    lines = lines[:-1]
-                for line in lines:
-                    prefix = unit.encode("utf-8")
-                    content = prefix+b": "+line+b"\n"
-                    os.write(1, content)
-                    try: os.fsync(1)
-                    except: pass
+                self._log_hold[unit] = lines[-1] # empty if text endswith newline
+                lines = lines[:-1]
+                if not lines: continue
+                if unit in self._log_tee:
+                    self.tee_journal_log(unit, b"\n".join(lines) + b"\n")
+                else:
+                    self.index_journal_log(unit, os.lseek(self._log_file[unit], 0, os.SEEK_CUR) - len(text))
+                prefix = unit.encode("utf-8") + b": "
+                content = prefix + (b"\n" + prefix).join(lines) + b"\n"
+                while content:
+                    try:
+                        written = os.write(1, content)
+                    except OSError as e:
+                        if e.errno in [ errno.EAGAIN, errno.EINTR ]:
+                            continue
+                        raise
+                    content = content[written:]
+    def index_journal_log(self, unit, offset, stamp = None):
+        """ append 'timestamp offset' to the journal index of the unit - at most
+            every JournalIndexSec, so that --since/--until can seek into its log """
+        now = stamp or time.time()
+        if unit in self._log_index:
+            _, last, lastoffset = self._log_index[unit]
+            if now < last + JournalIndexSec or offset <= lastoffset:
+                return # the old lines are read again at init
+        if unit not in self._log_index:
+            conf = self.load_unit_conf(unit)
+            if conf is None:
+                return
+            index_file = self.get_journal_index_from(conf)
+            try:
+                indexed = os.open(index_file, os.O_WRONLY | os.O_APPEND | os.O_CREAT, 0o644)
+            except OSError as e:
+                logg.debug("can not open %s journal index: %s\n\t%s", unit, index_file, e)
+                return
+            fcntl.fcntl(indexed, fcntl.F_SETFD, fcntl.FD_CLOEXEC)
+            self._log_index[unit] = (indexed, 0, -1)
+        indexed = self._log_index[unit][0]
+        os.write(indexed, ("%.3f %i\n" % (now, offset)).encode("utf-8"))
+        self._log_index[unit] = (indexed, now, offset)
+    def stop_journal_index(self, unit, remove = False):
+        if unit in self._log_index:
+            os.close(self._log_index[unit][0])
+            del self._log_index[unit]
+        if remove:
+            conf = self.load_unit_conf(unit)
+            if conf is not None:
+                index_file = self.get_journal_index_from(conf)
+                if os.path.exists(index_file):
+                    os.remove(index_file)
     def stop_log_files(self, units):
         for unit in units:
+            if unit in self._log_tee:
+                continue # see stop_journal_pipes
+            self.stop_journal_index(unit)
             try:
                 if unit in self._log_file:
                     if self._log_file[unit]:
                         os.close(self._log_file[unit])
+                    del self._log_file[unit]
+                    del self._log_hold[unit]
             except Exception as e:
                 logg.error("can not close log: %s\n\t%s", unit, e)
-        self._log_file = {}
-        self._log_hold = {}
+    def stop_journal_pipes(self, units):
+        """ after the units are stopped - remove the fifos (see start_journal_pipes) """
+        forwarder = self._log_forwarder
+        if forwarder:
+            forwarder.stop()
+            forwarder.join(2)
+            if forwarder.is_alive():
+                logg.warning("log forwarder did not stop - skipping the last logs")
+            else:
+                self._log_forwarder = None
+                self.read_log_files(units)
+        else:
+            self.read_log_files(units)
+        for unit in units:
+            if unit in self._log_tee:
+                conf = self.load_unit_conf(unit)
+                if conf is not None:
+                    pipe_file = self.get_journal_pipe_from(conf)
+                    if os.path.exists(pipe_file):
+                        os.remove(pipe_file)
+        if self._log_forwarder:
+            return # the log files are still in use by the forwarder thread
+        for unit in units:
+            if unit in self._log_tee:
+                os.close(self._log_tee[unit])
+        self._log_tee = {}
+        self.stop_log_files(units)
 
     def get_StartLimitBurst(self, conf):
         defaults = DefaultStartLimitBurst
@@ -5751,6 +7931,23 @@ class Systemctl:
         maximum = maximum or DefaultStartLimitIntervalSec
         delay = conf.get("Service", "RestartSec", strE(DefaultRestartSec))
         return time_to_seconds(delay, maximum)
+    def get_RestartSteps(self, conf):
+        return to_int(conf.get("Service", "RestartSteps", "0"), 0)
+    def get_RestartMaxDelaySec(self, conf):
+        delay = conf.get("Service", "RestartMaxDelaySec", "infinity")
+        if delay.strip() in [ "", "infinity" ]:
+            return None
+        return time_to_seconds(delay, DefaultTimeoutAbortSec)
+    def get_RestartDelay(self, conf, restarts = 0):
+        """ the RestartSec grows exponentially with the restarts in a row, so
+            that it reaches RestartMaxDelaySec after RestartSteps restarts """
+        restartSec = self.get_RestartSec(conf)
+        steps = self.get_RestartSteps(conf)
+        maxDelay = self.get_RestartMaxDelaySec(conf)
+        if steps <= 0 or maxDelay is None or maxDelay <= restartSec:
+            return restartSec
+        base = max(restartSec, DefaultRestartSec)
+        return base * (maxDelay / base) ** (float(min(restarts, steps)) / steps)
     def restart_failed_units(self, units, maximum = None):
         """ This function will retart failed units.
         /
@@ -5760,11 +7957,16 @@ class Systemctl:
         rounds have come here checking for possible restarts. You can directly shorten
         the interval ('-c InitLoopSleep=1') or have it indirectly shorter from the
         service descriptor's RestartSec ("RestartSec=2s").
+        /
+        In the event-driven InitLoop (INIT_LOOP_EVENTS) the failure is seen on SIGCHLD
+        and the restart deadline is put on the init-loop timers, so InitLoopSleep is
+        not changed at all. The restarts are then counted at their exact time for the
+        StartLimitIntervalSec window, and a unit that fails again right after its
+        restart waits longer each time (RestartSteps up to RestartMaxDelaySec).
         """
         global InitLoopSleep
         me = os.getpid()
         maximum = maximum or DefaultStartLimitIntervalSec
-        restartDelay = MinimumYield
         for unit in units:
             now = time.time()
             try:
@@ -5775,7 +7977,9 @@ class Systemctl:
                     logg.debug("[%s] [%s] Current NoCheck (Restart=%s)", me, unit, restartPolicy)
                     continue
                 restartSec = self.get_RestartSec(conf)
-                if restartSec == 0:
+                if self._loop_wakeup:
+                    pass # the restart deadline is put on the init-loop timers
+                elif restartSec == 0:
                     if InitLoopSleep > 1:
                         logg.warning("[%s] set InitLoopSleep from %ss to 1 (caused by RestartSec=0!)", 
                             unit, InitLoopSleep)
@@ -5795,33 +7999,17 @@ class Systemctl:
                     continue
                 limitBurst = self.get_StartLimitBurst(conf)
                 limitSecs = self.get_StartLimitIntervalSec(conf)
-                if limitBurst > 1 and limitSecs >= 1:
+                if limitBurst > 1 and limitSecs > 0:
                     try:
-                        if unit not in self._restarted_unit:
-                            self._restarted_unit[unit] = []
-                            # we want to register restarts from now on
-                        restarted = self._restarted_unit[unit]
+                        # only the restarts within the last limitSecs are counted
+                        restarted = [ t for t in self._restarted_unit.get(unit, []) if now - t < limitSecs ]
+                        self._restarted_unit[unit] = restarted
                         logg.debug("[%s] [%s] Current limitSecs=%ss limitBurst=%sx (restarted %sx)", 
                             me, unit, limitSecs, limitBurst, len(restarted))
-                        oldest = 0.
-                        interval = 0.
-                        if len(restarted) >= limitBurst:
-                            logg.debug("[%s] [%s] restarted %s", 
-                                me, unit, [ "%.3fs" % (t - now) for t in restarted ])
-                            while len(restarted):
-                                oldest = restarted[0]
-                                interval = time.time() - oldest
-                                if interval > limitSecs:
-                                    restarted = restarted[1:]
-                                    continue
-                                break
-                            self._restarted_unit[unit] = restarted
-                            logg.debug("[%s] [%s] ratelimit %s", 
-                                me, unit, [ "%.3fs" % (t - now) for t in restarted ])
-                            # all values in restarted have a time below limitSecs
                         if len(restarted) >= limitBurst:
+                            oldest = restarted[0]
                             logg.info("[%s] [%s] Blocking Restart - oldest %s is %s ago (allowed %s)", 
-                               me, unit, oldest, interval, limitSecs)
+                               me, unit, oldest, now - oldest, limitSecs)
                             self.write_status_from(conf, AS="error")
                             unit = "" # dropped out
                             continue
@@ -5829,9 +8017,15 @@ class Systemctl:
                         logg.error("[%s] burst exception %s", unit, e)
                 if unit: # not dropped out
                     if unit not in self._restart_failed_units:
-                        self._restart_failed_units[unit] = now + restartSec
-                        logg.debug("[%s] [%s] restart scheduled in %+.3fs", 
-                            me, unit, (self._restart_failed_units[unit] - now))
+                        restarts, restarted_at = self._restart_backoff.get(unit, (0, 0.))
+                        if restarts and now - restarted_at > (self.get_RestartMaxDelaySec(conf) or restartSec):
+                            restarts = 0 # it was running long enough
+                        restartDelay = self.get_RestartDelay(conf, restarts)
+                        self._restart_backoff[unit] = (restarts, restarted_at)
+                        self._restart_failed_units[unit] = now + restartDelay
+                        self.init_loop_timer(now + restartDelay, unit)
+                        logg.debug("[%s] [%s] restart scheduled in %+.3fs (%s restarts in a row)", 
+                            me, unit, (self._restart_failed_units[unit] - now), restarts)
             except Exception as e:
                 logg.error("[%s] [%s] An error ocurred while restart checking: %s", me, unit, e)
         if not self._restart_failed_units:
@@ -5857,9 +8051,12 @@ class Systemctl:
                 if isUnitFailed:
                     logg.debug("[%s] [%s] --- restarting failed unit...", me, unit)
                     self.restart_unit(unit)
+                    self._restart_counts[unit] = self._restart_counts.get(unit, 0) + 1
                     logg.debug("[%s] [%s] --- has been restarted.", me, unit)
-                    if unit in self._restarted_unit:
-                        self._restarted_unit[unit].append(time.time())
+                    restarted_at = time.time()
+                    self._restarted_unit.setdefault(unit, []).append(restarted_at)
+                    restarts = self._restart_backoff.get(unit, (0, 0.))[0]
+                    self._restart_backoff[unit] = (restarts + 1, restarted_at)
             except Exception as e:
                 logg.error("[%s] [%s] An error ocurred while restarting: %s", me, unit, e)
         for unit in restart_done:
@@ -5869,123 +8066,354 @@ class Systemctl:
             me, [ "%+.3fs" % (t - now) for t in self._restart_failed_units.values() ])
         return restart_done
 
+    def init_loop_timer(self, deadline, unit = ""):
+        """ wake up the init-loop at the deadline (if it runs event-driven) """
+        if self._loop_wakeup:
+            heapq.heappush(self._loop_timers, (deadline, unit))
+    def init_loop_timeout(self, timeout):
+        """ the time to wait for the next deadline, but not longer than timeout """
+        now = time.time()
+        while self._loop_timers and self._loop_timers[0][0] <= now:
+            heapq.heappop(self._loop_timers)
+        if self._loop_timers:
+            deadline = self._loop_timers[0][0]
+            if deadline - now < timeout:
+                return deadline - now
+        return max(timeout, 0)
+    def init_loop_events(self):
+        """ install the SIGCHLD wakeup pipe for the event-driven init-loop """
+        if not INIT_LOOP_EVENTS:
+            return False
+        try:
+            wakeup = os.pipe()
+            for fd in wakeup:
+                fcntl.fcntl(fd, fcntl.F_SETFD, fcntl.fcntl(fd, fcntl.F_GETFD) | fcntl.FD_CLOEXEC)
+                fcntl.fcntl(fd, fcntl.F_SETFL, fcntl.fcntl(fd, fcntl.F_GETFL) | os.O_NONBLOCK)
+            signal.set_wakeup_fd(wakeup[1])
+        except Exception as e: # not in the main thread
+            logg.debug("no init-loop events: %s", e)
+            return False
+        signal.signal(signal.SIGCHLD, lambda signum, frame: None)
+        signal.siginterrupt(signal.SIGCHLD, False)
+        self._loop_wakeup = wakeup
+        self._loop_timers = []
+        return True
+    def init_loop_events_done(self):
+        if self._loop_wakeup:
+            signal.set_wakeup_fd(-1)
+            signal.signal(signal.SIGCHLD, signal.SIG_DFL)
+            for fd in self._loop_wakeup:
+                os.close(fd)
+        self._loop_wakeup = None
+        self._loop_timers = []
+    def init_loop_wait(self, timeout):
+        """ wait for a signal (SIGCHLD) or a readable log fd or the timeout """
+        wakeup = self._loop_wakeup[0]
+        watch = [ wakeup ]
+        for log_fd in self._log_file.values():
+            if LOG_FORWARDER:
+                break # the SystemctlLogForwarder does it
+            if stat.S_ISFIFO(os.fstat(log_fd).st_mode):
+                watch.append(log_fd) # regular files are always readable
+        try:
+            readable, _, _ = select.select(watch, [], [], timeout)
+        except (select.error, OSError, IOError): # EINTR on python2
+            readable = [ wakeup ]
+        if wakeup in readable:
+            try:
+                while os.read(wakeup, 512): pass
+            except (OSError, IOError):
+                pass # EAGAIN
+        return readable
+    def control_socket_file(self):
+        return os_path(self._root, expand_path(_control_socket_file, not self.user_mode()))
+    def control_options(self):
+        """ the command line options that are sent along with a control request """
+        options = {}
+        for name in [ "_force", "_full", "_no_ask_password", "_no_legend", "_preset_mode", "_quiet",
+                      "_show_all", "_timings", "_unit_property", "_unit_state", "_unit_type" ]:
+            options[name] = getattr(self, name)
+        return options
+    def control_request(self, request):
+        """ run the command of a control socket client in the PID-1 with its unit
+            files - on a copy of this Systemctl with the options of the client and
+            with unit confs of its own (as if it were a process of its own). The
+            ReadOnlyCommands run right away, the others wait for the init-loop lock
+            and the init-loop waits for them (see ControlStdout and ControlLogFilter
+            for the printed output and the messages) // exitcode """
+        command = request.get("command", "")
+        modules = request.get("modules", [])
+        options = request.get("options", {})
+        if command not in ControlCommands:
+            logg.error("Unknown operation %s.", command)
+            return NOT_OK
+        logg.info("control: %s %s", command, " ".join(modules))
+        systemctl = copy.copy(self)
+        for name, value in options.items():
+            if name in self.control_options():
+                setattr(systemctl, name, value)
+        systemctl._init = False
+        systemctl._read_only = command in ReadOnlyCommands
+        systemctl._loaded_file_sysd = {} # not the conf objects (and status) of the init-loop
+        systemctl._loaded_file_sysv = {}
+        systemctl._unit_cache_sysd_confs = dict(self._unit_cache_sysd_confs)
+        systemctl._dependencies = {}
+        systemctl._dependencies_closure = {}
+        systemctl.error = NOT_A_PROBLEM
+        me = os.getpid()
+        try:
+            systemctl.refresh_unit_files()
+            if systemctl._read_only:
+                result = command_of(systemctl, command)(*modules)
+            else:
+                with self.loop: # the init-loop does not check the units meanwhile
+                    self.refresh_unit_files()
+                    result = command_of(systemctl, command)(*modules)
+            exitcode = print_result(result)
+            exitcode |= systemctl.error
+        except Exception as e:
+            if os.getpid() != me: # pragma: no cover
+                os._exit(NOT_OK) # a forked child must not answer the request
+            logg.error("control %s: %s", command, e)
+            exitcode = NOT_OK
+        return exitcode
     def init_loop_until_stop(self, units):
         """ this is the init-loop - it checks for any zombies to be reaped and
             waits for an interrupt. When a SIGTERM /SIGINT /Control-C signal
             is received then the signal name is returned. Any other signal will 
             just raise an Exception like one would normally expect. As a special
-            the 'systemctl halt' emits SIGQUIT which puts it into no_more_procs mode."""
+            the 'systemctl halt' emits SIGQUIT which puts it into no_more_procs mode.
+            With INIT_LOOP_EVENTS it does not sleep in ticks but it wakes up on
+            SIGCHLD and on the next timer deadline (InitLoopSleep at most)."""
         signal.signal(signal.SIGQUIT, lambda signum, frame: ignore_signals_and_raise_keyboard_interrupt("SIGQUIT"))
         signal.signal(signal.SIGINT, lambda signum, frame: ignore_signals_and_raise_keyboard_interrupt("SIGINT"))
         signal.signal(signal.SIGTERM, lambda signum, frame: ignore_signals_and_raise_keyboard_interrupt("SIGTERM"))
         #
         self.start_log_files(units)
+        forwarder = None
+        if LOG_FORWARDER and self._log_file:
+            forwarder = SystemctlLogForwarder(self, units)
+            forwarder.start()
+            if self._log_tee:
+                self._log_forwarder = forwarder # until stop_journal_pipes
         logg.debug("start listen")
         listen = SystemctlListenThread(self)
         logg.debug("starts listen")
         listen.start()
         logg.debug("started listen")
+        control = None
+        if CONTROL_SOCKET:
+            control = SystemctlControlThread(self)
+            control.start()
         self.sysinit_status(ActiveState = "active", SubState = "running")
+        if METRICS_TEXTFILE:
+            self.write_metrics_textfile(units)
+        events = self.init_loop_events()
         timestamp = time.time()
         result = None
-        while True:
-            try:
-                if DEBUG_INITLOOP: # pragma: no cover
-                    logg.debug("DONE InitLoop (sleep %ss)", InitLoopSleep)
-                sleep_sec = InitLoopSleep - (time.time() - timestamp)
-                if sleep_sec < MinimumYield:
-                    sleep_sec = MinimumYield
-                sleeping = sleep_sec
-                while sleeping > 2:
-                    time.sleep(1) # accept signals atleast every second
-                    sleeping = InitLoopSleep - (time.time() - timestamp)
-                    if sleeping < MinimumYield:
-                       sleeping = MinimumYield
-                       break
-                time.sleep(sleeping) # remainder waits less that 2 seconds
-                timestamp = time.time()
-                self.loop.acquire()
-                if DEBUG_INITLOOP: # pragma: no cover
-                    logg.debug("NEXT InitLoop (after %ss)", sleep_sec)
-                self.read_log_files(units)
-                if DEBUG_INITLOOP: # pragma: no cover
-                    logg.debug("reap zombies - check current processes")
-                running = self.system_reap_zombies()
-                if DEBUG_INITLOOP: # pragma: no cover
-                    logg.debug("reap zombies - init-loop found %s running procs", running)
-                if self.doExitWhenNoMoreServices:
-                    active = False
-                    for unit in units:
-                        conf = self.load_unit_conf(unit)
-                        if not conf: continue
-                        if self.is_active_from(conf):
-                            active = True
-                    if not active:
-                        logg.info("no more services - exit init-loop")
-                        break
-                if self.doExitWhenNoMoreProcs:
-                    if not running:
-                        logg.info("no more procs - exit init-loop")
-                        break
-                if RESTART_FAILED_UNITS:
-                    self.restart_failed_units(units)
+        locked = False # a signal may interrupt the wait for a control request
+        try:
+            while True:
+                try:
+                    if DEBUG_INITLOOP: # pragma: no cover
+                        logg.debug("DONE InitLoop (sleep %ss)", InitLoopSleep)
+                    sleep_sec = InitLoopSleep - (time.time() - timestamp)
+                    if events:
+                        sleep_sec = self.init_loop_timeout(sleep_sec)
+                        self.init_loop_wait(sleep_sec)
+                    else:
+                        if sleep_sec < MinimumYield:
+                            sleep_sec = MinimumYield
+                        sleeping = sleep_sec
+                        while sleeping > 2:
+                            time.sleep(1) # accept signals atleast every second
+                            sleeping = InitLoopSleep - (time.time() - timestamp)
+                            if sleeping < MinimumYield:
+                               sleeping = MinimumYield
+                               break
+                        time.sleep(sleeping) # remainder waits less that 2 seconds
+                    timestamp = time.time()
+                    self.loop.acquire()
+                    locked = True
+                    if DEBUG_INITLOOP: # pragma: no cover
+                        logg.debug("NEXT InitLoop (after %ss)", sleep_sec)
+                    if not forwarder:
+                        self.read_log_files(units)
+                    if DEBUG_INITLOOP: # pragma: no cover
+                        logg.debug("reap zombies - check current processes")
+                    running = self.system_reap_zombies()
+                    if DEBUG_INITLOOP: # pragma: no cover
+                        logg.debug("reap zombies - init-loop found %s running procs", running)
+                    if self.doExitWhenNoMoreServices:
+                        active = False
+                        for unit in units:
+                            conf = self.load_unit_conf(unit)
+                            if not conf: continue
+                            if self.is_active_from(conf):
+                                active = True
+                        if not active:
+                            logg.info("no more services - exit init-loop")
+                            break
+                    if self.doExitWhenNoMoreProcs:
+                        if not running:
+                            logg.info("no more procs - exit init-loop")
+                            break
+                    if RESTART_FAILED_UNITS:
+                        self.restart_failed_units(units)
+                    self._loop_ticks[0] += 1
+                    self._loop_ticks[1] += time.time() - timestamp
+                    if METRICS_TEXTFILE:
+                        self.write_metrics_textfile(units)
+                    locked = False
+                    self.loop.release()
+                except KeyboardInterrupt as e:
+                    if locked:
+                        locked = False
+                        self.loop.release()
+                    if e.args and e.args[0] == "SIGQUIT":
+                        # the original systemd puts a coredump on that signal.
+                        logg.info("SIGQUIT - switch to no more procs check")
+                        self.doExitWhenNoMoreProcs = True
+                        continue
+                    signal.signal(signal.SIGTERM, signal.SIG_DFL)
+                    signal.signal(signal.SIGINT, signal.SIG_DFL)
+                    logg.info("interrupted - exit init-loop")
+                    result = str(e) or "STOPPED"
+                    break
+                except Exception as e:
+                    logg.info("interrupted - exception %s", e)
+                    raise
+        finally:
+            self.init_loop_events_done()
+            self.sysinit_status(ActiveState = None, SubState = "degraded")
+            if locked:
                 self.loop.release()
-            except KeyboardInterrupt as e:
-                if e.args and e.args[0] == "SIGQUIT":
-                    # the original systemd puts a coredump on that signal.
-                    logg.info("SIGQUIT - switch to no more procs check")
-                    self.doExitWhenNoMoreProcs = True
-                    continue
-                signal.signal(signal.SIGTERM, signal.SIG_DFL)
-                signal.signal(signal.SIGINT, signal.SIG_DFL)
-                logg.info("interrupted - exit init-loop")
-                result = str(e) or "STOPPED"
-                break
-            except Exception as e:
-                logg.info("interrupted - exception %s", e)
-                raise
-        self.sysinit_status(ActiveState = None, SubState = "degraded")
-        try: self.loop.release()
-        except: pass
-        listen.stop()
-        listen.join(2)
-        self.read_log_files(units)
-        self.read_log_files(units)
-        self.stop_log_files(units)
+            listen.stop()
+            listen.join(2)
+            if control:
+                control.stop()
+                control.join(2)
+            if forwarder and not self._log_forwarder:
+                forwarder.stop()
+                forwarder.join(2)
+            if forwarder and not self._log_forwarder and forwarder.is_alive():
+                logg.warning("log forwarder did not stop - skipping the last logs")
+            else: # the forwarder thread does not use the log files anymore
+                if not self._log_forwarder:
+                    self.read_log_files(units)
+                    self.read_log_files(units)
+                self.stop_log_files(units)
+            if self._log_tee and not self._log_forwarder:
+                forwarder = SystemctlLogForwarder(self, units)
+                forwarder.start() # drain the fifos while the units are stopped
+                self._log_forwarder = forwarder # until stop_journal_pipes
+            if METRICS_TEXTFILE:
+                self.remove_metrics_textfile()
+            self.done_cgroups() # the units are stopped by this process (which knows its base)
         logg.debug("done - init loop")
         return result
+    def metrics_textfile(self):
+        return os_path(self._root, expand_path(_metrics_textfile, not self.user_mode()))
+    def metrics_text(self, units):
+        """ the init-loop state in the prometheus text format - it is only read
+            from memory and the status files, so no process is forked """
+        def label(value):
+            return strE(value).replace("\\", "\\\\").replace('"', '\\"')
+        state_lines, mainpid_lines, procs_lines, restart_lines, start_lines = [], [], [], [], []
+        with batchstates(self):
+            for unit in units:
+                conf = self.load_unit_conf(unit)
+                if conf is None:
+                    continue
+                name = label(unit)
+                state = self.get_active_from(conf)
+                states = [ "active", "inactive", "failed" ]
+                if state not in states:
+                    states.append(state)
+                for known in states:
+                    state_lines.append('systemctl_unit_state{unit="%s",state="%s"} %s' % (name, label(known), int(known == state)))
+                mainpid = self.read_mainpid_from(conf) or 0
+                mainpid_lines.append('systemctl_unit_main_pid{unit="%s"} %s' % (name, mainpid))
+                procs = len(self.cgroup_pids_from(conf))
+                if not procs and mainpid and self.pid_alive(mainpid):
+                    procs = 1
+                procs_lines.append('systemctl_unit_processes{unit="%s"} %s' % (name, procs))
+                restart_lines.append('systemctl_unit_restarts_total{unit="%s"} %s' % (name, self._restart_counts.get(unit, 0)))
+                histogram = self._start_seconds.get(unit)
+                if histogram:
+                    for idx, bucket in enumerate(_metrics_start_buckets):
+                        start_lines.append('systemctl_unit_start_seconds_bucket{unit="%s",le="%s"} %s' % (name, bucket, histogram[idx]))
+                    start_lines.append('systemctl_unit_start_seconds_bucket{unit="%s",le="+Inf"} %s' % (name, histogram[-2]))
+                    start_lines.append('systemctl_unit_start_seconds_sum{unit="%s"} %.6f' % (name, histogram[-1]))
+                    start_lines.append('systemctl_unit_start_seconds_count{unit="%s"} %s' % (name, histogram[-2]))
+        text = []
+        text += [ "# HELP systemctl_unit_state The ActiveState of the unit.", "# TYPE systemctl_unit_state gauge" ] + state_lines
+        text += [ "# HELP systemctl_unit_main_pid The MainPID of the unit.", "# TYPE systemctl_unit_main_pid gauge" ] + mainpid_lines
+        text += [ "# HELP systemctl_unit_processes The processes of the unit.", "# TYPE systemctl_unit_processes gauge" ] + procs_lines
+        text += [ "# HELP systemctl_unit_restarts_total The restarts of the failed unit.", "# TYPE systemctl_unit_restarts_total counter" ] + restart_lines
+        text += [ "# HELP systemctl_unit_start_seconds The time the unit took to start.", "# TYPE systemctl_unit_start_seconds histogram" ] + start_lines
+        text += [ "# HELP systemctl_processes The processes in the container (except PID-1).", "# TYPE systemctl_processes gauge" ]
+        text += [ "systemctl_processes %s" % (self._running_procs or 0) ]
+        text += [ "# HELP systemctl_reaped_zombies_total The zombies reaped by the init-loop.", "# TYPE systemctl_reaped_zombies_total counter" ]
+        text += [ "systemctl_reaped_zombies_total %s" % self._reaped_zombies ]
+        text += [ "# HELP systemctl_init_loop_tick_seconds The time of the init-loop ticks.", "# TYPE systemctl_init_loop_tick_seconds summary" ]
+        text += [ "systemctl_init_loop_tick_seconds_sum %.6f" % self._loop_ticks[1], "systemctl_init_loop_tick_seconds_count %s" % self._loop_ticks[0] ]
+        return "\n".join(text) + "\n"
+    def write_metrics_textfile(self, units):
+        """ for the textfile collector of a prometheus node_exporter (METRICS_TEXTFILE) """
+        now = time.time()
+        if now - self._metrics_written < MetricsIntervalSec:
+            return False
+        self._metrics_written = now
+        textfile = self.metrics_textfile()
+        texttemp = path_temp_name(textfile)
+        try:
+            folder = os.path.dirname(textfile)
+            if not os.path.isdir(folder):
+                os.makedirs(folder)
+            with open(texttemp, "w") as f:
+                f.write(self.metrics_text(units))
+            os.rename(texttemp, textfile)
+        except (IOError, OSError) as e:
+            logg.warning("can not write metrics %s: %s", textfile, e)
+            return False
+        return True
+    def remove_metrics_textfile(self):
+        textfile = self.metrics_textfile()
+        if os.path.exists(textfile):
+            os.remove(textfile) # no stale metrics after PID-1 has gone
     def system_reap_zombies(self):
-        """ check to reap children """
+        """ check to reap children - and count the running procs on each tick
+            as a process may go away without being our child. """
+        reaped = self.reap_zombies()
+        self._reaped_zombies += len(reaped)
+        self._running_procs = self.count_running_procs()
+        return self._running_procs # except PID 0 and PID 1
+    def reap_zombies(self):
+        """ collect all dead children - returns the pids reaped """
+        reaped = []
+        while True:
+            try:
+                pid, status = reap_zombie()
+            except OSError as e:
+                if e.errno == errno.EINTR:
+                    continue
+                break # ECHILD - no more children
+            if not pid:
+                break # some children but none is dead
+            logg.info("reap zombie %s", pid)
+            reaped.append(pid)
+        return reaped
+    def count_running_procs(self):
+        """ the processes in the container (except PID 0 and PID 1 and self).
+            When running as PID 1 then all orphans are reparented to us, so that
+            the number can only go down to zero when a child gets reaped. """
         selfpid = os.getpid()
         running = 0
-        for pid_entry in os.listdir(_proc_pid_dir):
-            pid = to_intN(pid_entry)
-            if pid is None:
-                continue
-            if pid == selfpid:
-                continue
-            proc_status = _proc_pid_status.format(**locals())
-            if os.path.isfile(proc_status):
-                zombie = False
-                ppid = -1
-                try:
-                    for line in open(proc_status):
-                        m = re.match(r"State:\s*Z.*", line)
-                        if m: zombie = True
-                        m = re.match(r"PPid:\s*(\d+)", line)
-                        if m: ppid = int(m.group(1))
-                except IOError as e:
-                    logg.warning("%s : %s", proc_status, e)
-                    continue
-                if zombie and ppid == os.getpid():
-                    logg.info("reap zombie %s", pid)
-                    try: os.waitpid(pid, os.WNOHANG)
-                    except OSError as e: 
-                        logg.warning("reap zombie %s: %s", e.strerror)
-            if os.path.isfile(proc_status):
-                if pid > 1:
-                    running += 1
-        return running # except PID 0 and PID 1
+        for pid in ProcTable().pids():
+            if pid > 1 and pid != selfpid:
+                running += 1
+        return running
     def sysinit_status(self, **status):
         conf = self.sysinit_target()
         self.write_status_from(conf, **status)
@@ -6032,33 +8460,11 @@ class Systemctl:
     def is_running_unit(self, unit):
         conf = self.get_unit_conf(unit)
         return self.is_running_unit_from(conf)
-    def pidlist_of(self, pid):
+    def pidlist_of(self, pid, proctable = None):
         if not pid:
             return []
-        pidlist = [ pid ]
-        pids = [ pid ]
-        for depth in xrange(PROC_MAX_DEPTH):
-            for pid_entry in os.listdir(_proc_pid_dir):
-                pid = to_intN(pid_entry)
-                if pid is None:
-                    continue
-                proc_status = _proc_pid_status.format(**locals())
-                if os.path.isfile(proc_status):
-                    try:
-                        for line in open(proc_status):
-                            if line.startswith("PPid:"):
-                                ppid_text = line[len("PPid:"):].strip()
-                                try: ppid = int(ppid_text)
-                                except: continue
-                                if ppid in pidlist and pid not in pids:
-                                    pids += [ pid ]
-                    except IOError as e:
-                        logg.warning("%s : %s", proc_status, e)
-                        continue
-            if len(pids) != len(pidlist):
-                pidlist = pids[:]
-                continue
-        return pids
+        proctable = proctable or ProcTable()
+        return proctable.descendants(pid)
     def echo(self, *targets):
         line = " ".join(*targets)
         logg.info(" == echo == %s", line)
@@ -6072,6 +8478,7 @@ class Systemctl:
         mapping[":9"] = signal.SIGKILL
         mapping[":KILL"] = signal.SIGKILL
         sig = signal.SIGTERM
+        proctable = ProcTable()
         for target in targets:
             if target.startswith(":"):
                 if target in mapping:
@@ -6079,12 +8486,10 @@ class Systemctl:
                 else: # pragma: no cover
                     logg.error("unsupported %s", target)
                 continue
-            for pid_entry in os.listdir(_proc_pid_dir):
-                pid = to_intN(pid_entry)
+            for pid in proctable.pids():
                 if pid:
                     try:
-                        cmdline = _proc_pid_cmdline.format(**locals())
-                        cmd = open(cmdline).read().split("\0")
+                        cmd = proctable.cmdline(pid)
                         if DEBUG_KILLALL: logg.debug("cmdline %s", cmd)
                         found = None
                         cmd_exe = os.path.basename(cmd[0])
@@ -6274,6 +8679,57 @@ def print_result(result):
         logg.warning("EXEC END Unknown result type %s", str(type(result)))
     return exitcode
 
+def command_of(systemctl, command): # -> callable(*modules)?
+    """ the Systemctl method that runs the command (with the unit names) """
+    if command.startswith("__"):
+        command_func = getattr(systemctl, command[2:], None)
+        if callable(command_func):
+            return command_func
+    command_name = command.replace("-","_").replace(".","_")
+    for method_name in [ command_name+"_modules", "show_"+command_name ]:
+        command_func = getattr(systemctl, method_name, None)
+        if callable(command_func):
+            return command_func
+    for method_name in [ "system_"+command_name, "systems_"+command_name ]:
+        command_func = getattr(systemctl, method_name, None)
+        if callable(command_func):
+            return lambda *modules: command_func() # no unit names
+    return None
+
+def control_client(systemctl, command, modules): # -> exitcode?
+    """ let the PID-1 run the command when it serves the control socket - None
+        is returned when there is no such PID-1 (or it did not reply within the
+        ControlTimeoutSec) so that the command runs here """
+    socketfile = systemctl.control_socket_file()
+    if not os.path.exists(socketfile):
+        return None
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    if command in ReadOnlyCommands:
+        sock.settimeout(ControlTimeoutSec)
+    else:
+        sock.settimeout(ControlTimeoutSec + DefaultMaximumTimeout) # waiting for other requests
+    try:
+        sock.connect(socketfile)
+        request = { "command": command, "modules": modules, "options": systemctl.control_options() }
+        sock.sendall((json.dumps(request) + "\n").encode("utf-8"))
+        data = b""
+        while True:
+            chunk = sock.recv(65536)
+            if not chunk:
+                break
+            data += chunk
+    except socket.error as e:
+        logg.debug("control socket %s: %s", socketfile, e)
+        return None
+    finally:
+        sock.close()
+    if not data:
+        return None # PID-1 has gone away
+    reply = json.loads(data.decode("utf-8"), object_hook = json_str_hook)
+    sys.stdout.write(reply["stdout"])
+    sys.stderr.write(reply["stderr"])
+    return reply["exitcode"]
+
 if __name__ == "__main__":
     import optparse
     _o = optparse.OptionParser("%prog [options] command [name...]", 
@@ -6338,12 +8794,18 @@ if __name__ == "__main__":
         help="Enable unit files in the specified root directory (used for alternative root prefix)")
     _o.add_option("-n","--lines", metavar="NUM",
         help="Number of journal entries to show")
+    _o.add_option("--since", metavar="TIME",
+        help="Show journal entries written since the time (e.g. '5 min ago') - in JournalIndexSec steps, all without a log index")
+    _o.add_option("--until", metavar="TIME",
+        help="Show journal entries written until the time (e.g. 'today') - in JournalIndexSec steps, all without a log index")
     _o.add_option("-o","--output", metavar="CAT",
         help="change journal output mode [short, ..., cat] (ignored)")
     _o.add_option("--plain", action="store_true",
         help="Print unit dependencies as a list instead of a tree (ignored)")
     _o.add_option("--no-pager", action="store_true",
         help="Do not pipe output into pager (mostly ignored)")
+    _o.add_option("--timings", action="store_true", default=_timings,
+        help="..record the start/stop phases in the status files (see analyze)")
     #
     _o.add_option("-c","--config", metavar="NAME=VAL", action="append", default=[],
         help="..override internal variables (InitLoopSleep,SysInitTarget) {%default}")
@@ -6366,6 +8828,8 @@ if __name__ == "__main__":
     _full = opt.full
     _log_lines = opt.lines
     _no_pager = opt.no_pager
+    _log_since = opt.since
+    _log_until = opt.until
     _no_reload = opt.no_reload
     _no_legend = opt.no_legend
     _no_ask_password = opt.no_ask_password
@@ -6373,6 +8837,7 @@ if __name__ == "__main__":
     _preset_mode = opt.preset_mode
     _quiet = opt.quiet
     _root = opt.root
+    _timings = opt.timings
     _show_all = opt.show_all
     _unit_state = opt.state
     _unit_type = opt.unit_type
@@ -6447,46 +8912,25 @@ if __name__ == "__main__":
     logg.debug("======= systemctl.py " + " ".join(args))
     command = args[0]
     modules = args[1:]
+    systemctl._read_only = command in ReadOnlyCommands
     try:
         modules.remove("service")
     except ValueError:
         pass
+    if CONTROL_SOCKET and command in ControlCommands and not _init:
+        if not (opt.config or opt.extra_vars or opt.verbose or opt.now or opt.no_reload or opt.what_kind or opt.ipv4 or opt.ipv6):
+            exitcode = control_client(systemctl, command, modules)
+            if exitcode is not None:
+                sys.exit(exitcode)
     if opt.ipv4:
         systemctl.force_ipv4()
     elif opt.ipv6:
         systemctl.force_ipv6()
-    found = False
-    # command NAME
-    if command.startswith("__"):
-        command_name = command[2:]
-        command_func = getattr(systemctl, command_name, None)
-        if callable(command_func) and not found:
-            found = True
-            result = command_func(*modules)
-    command_name = command.replace("-","_").replace(".","_")+"_modules"
-    command_func = getattr(systemctl, command_name, None)
-    if callable(command_func) and not found:
-        found = True
-        result = command_func(*modules)
-    command_name = "show_"+command.replace("-","_").replace(".","_")
-    command_func = getattr(systemctl, command_name, None)
-    if callable(command_func) and not found:
-        found = True
-        result = command_func(*modules)
-    command_name = "system_"+command.replace("-","_").replace(".","_")
-    command_func = getattr(systemctl, command_name, None)
-    if callable(command_func) and not found:
-        found = True
-        result = command_func()
-    command_name = "systems_"+command.replace("-","_").replace(".","_")
-    command_func = getattr(systemctl, command_name, None)
-    if callable(command_func) and not found:
-        found = True
-        result = command_func()
-    if not found:
+    command_func = command_of(systemctl, command)
+    if command_func is None:
         logg.error("Unknown operation %s.", command)
         sys.exit(1)
     #
-    exitcode = print_result(result)
+    exitcode = print_result(command_func(*modules))
     exitcode |= systemctl.error
     sys.exit(exitcode)
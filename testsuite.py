@@ -28,6 +28,7 @@ import sys
 import collections
 import signal
 import shlex
+import threading
 from fnmatch import fnmatchcase as fnmatch
 from glob import glob
 import json
@@ -939,6 +940,59 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.rm_testdir()
         self.rm_zzfiles(root)
         self.coverage()
+    def test_1012_systemctl_daemon_reload_unit_files_cache(self) -> None:
+        """ daemon-reload writes the unit files cache - and changed files are parsed again """
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        text_file(os_path(root, "/etc/systemd/system/zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            ExecStart=/bin/sleep 3
+        """)
+        #
+        cmd = "{systemctl} daemon-reload"
+        out,end = output2(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s", cmd, end, out)
+        self.assertEqual(end, 0)
+        cmd = "{systemctl} show zza.service -p Description -vvv"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertTrue(greps(err, "cached 1 sysd files"))
+        self.assertEqual(lines(out), ["Description=Testing A"])
+        text_file(os_path(root, "/etc/systemd/system/zza.service.d/zz.conf"),"""
+            [Service]
+            Environment=A=1
+        """)
+        cmd = "{systemctl} show zza.service -p Environment -vvv"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertEqual(lines(out), ["Environment=A=1"])
+        cmd = "{systemctl} daemon-reload"
+        out,end = output2(cmd.format(**locals()))
+        self.assertEqual(end, 0)
+        text_file(os_path(root, "/etc/systemd/system/zza.service.d/zz.conf"),"""
+            [Service]
+            Environment=A=22
+        """)
+        cmd = "{systemctl} show zza.service -p Environment -vvv"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertTrue(greps(err, "cached 1 sysd files"))
+        self.assertEqual(lines(out), ["Environment=A=22"])
+        text_file(os_path(root, "/etc/systemd/system/zzb.service"),"""
+            [Unit]
+            Description=Testing C
+        """)
+        cmd = "{systemctl} show zzb.service -p Description -vvv"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertTrue(greps(err, "found 2 sysd files"))
+        self.assertEqual(lines(out), ["Description=Testing C"])
+        self.rm_testdir()
+        self.rm_zzfiles(root)
+        self.coverage()
     def test_1019_systemctl_test_commands_work(self) -> None:
         """ some commands are internal for testing only """
         systemctl = cover() + _systemctl_py
@@ -4602,6 +4656,58 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.rm_testdir()
         self.coverage()
         ##
+    def test_2719_chown_state_tree_but_not_the_symlinks(self) -> None:
+        """ check that a StateDirectory tree is changed to User= without following symlinks """
+        import pwd
+        if os.geteuid() != 0:
+            self.skipTest("chown needs root")
+        try:
+            nobody = pwd.getpwnam("nobody")
+        except KeyError:
+            self.skipTest("no user nobody")
+        self.begin()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        import stat
+        folder = os.path.abspath(testdir)
+        while folder != os.path.dirname(folder):
+            folder = os.path.dirname(folder)
+            if not os.stat(folder).st_mode & stat.S_IXOTH:
+                self.rm_testdir()
+                self.skipTest("User=nobody can not reach the testdir below %s" % folder)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        text_file(os_path(root, "/etc/systemd/system/zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=oneshot
+            StateDirectory=zza
+            User=nobody
+            ExecStart=/bin/true
+            """.format(**locals()))
+        path = os_path(root, "/var/lib/zza")
+        outside = os_path(root, "/etc/outside.conf")
+        text_file(outside, "root owned")
+        for folder in ["a/b/c", "a/d", "e"]:
+            os.makedirs(os.path.join(path, folder))
+            text_file(os.path.join(path, folder, "data.txt"), "data")
+        os.symlink(outside, os.path.join(path, "a/d/link.conf"))
+        #
+        cmd = "{systemctl} start zza.service -c ChownParallelJobs=2 -vvv"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertEqual(end, 0)
+        for folder in ["", "a", "a/b", "a/b/c", "a/d", "e"]:
+            self.assertEqual(os.stat(os.path.join(path, folder)).st_uid, nobody.pw_uid)
+        for folder in ["a/b/c", "a/d", "e"]:
+            self.assertEqual(os.stat(os.path.join(path, folder, "data.txt")).st_uid, nobody.pw_uid)
+        self.assertEqual(os.lstat(os.path.join(path, "a/d/link.conf")).st_uid, nobody.pw_uid)
+        self.assertEqual(os.stat(outside).st_uid, 0)
+        #
+        self.rm_testdir()
+        self.coverage()
+        self.end()
     def test_2900_class_UnitConfParser(self) -> None:
         """ using systemctl.py as a helper library for
             the UnitConfParser functions."""
@@ -9221,6 +9327,67 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.rm_testdir()
         self.coverage()
         self.end()
+    def test_3212_changed_environment_files_are_read_again(self) -> None:
+        """ check that the init process does not run with an old EnvironmentFile """
+        self.begin()
+        self.rm_testdir()
+        self.rm_killall()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        logfile = os_path(root, "/var/log/test.log")
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        testsleep = self.testname("sleep")
+        bindir = os_path(root, "/usr/bin")
+        text_file(os_path(testdir, "zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleep} 99
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzz.service"),"""
+            [Unit]
+            Description=Testing Z
+            [Service]
+            Type=oneshot
+            EnvironmentFile=/etc/sysconfig/zzz.conf
+            ExecStart=/bin/sh -c 'echo "WITH CONF1=$CONF1" >> {logfile}'
+            """.format(**locals()))
+        text_file(os_path(root, "/etc/sysconfig/zzz.conf"),"""
+            CONF1=aa1
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleep))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        copy_file(os_path(testdir, "zzz.service"), os_path(root, "/etc/systemd/system/zzz.service"))
+        cmd = "{systemctl} enable zza.service"
+        sh____(cmd.format(**locals()))
+        os.makedirs(os_path(root, "/var/log"))
+        #
+        InitLoopSleep = 1
+        cmd = "{systemctl} -c InitLoopSleep={InitLoopSleep} -1"
+        init = background(cmd.format(**locals()))
+        time.sleep(InitLoopSleep+1)
+        cmd = "{systemctl} restart zzz.service"
+        sh____(cmd.format(**locals()))
+        text_file(os_path(root, "/etc/sysconfig/zzz.conf"),"""
+            CONF1=bbb2
+            """.format(**locals()))
+        cmd = "{systemctl} restart zzz.service"
+        sh____(cmd.format(**locals()))
+        #
+        log = lines(open(logfile))
+        logg.info("LOG \n| %s", "\n| ".join(log))
+        self.assertEqual(log, ["WITH CONF1=aa1", "WITH CONF1=bbb2"])
+        #
+        logg.info("kill daemon at %s", init.pid)
+        self.assertTrue(self.kill(init.pid))
+        self.rm_killall()
+        self.rm_testdir()
+        self.coverage()
+        self.end()
     def test_3240_may_expand_environment_variables(self) -> None:
         """ check that different styles of environment
             variables get expanded."""
@@ -9290,6 +9457,33 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.rm_testdir()
         self.coverage()
         self.end()
+    def test_3241_empty_variable_expands_to_no_command(self) -> None:
+        """ check that an exec command of just an empty variable has no
+            args at all (it used to be taken as the command '$EMPTY')."""
+        self.begin()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        text_file(os_path(root, "/etc/systemd/system/zzb.service"),"""
+            [Unit]
+            Description=Testing B
+            [Service]
+            Type=oneshot
+            Environment=EMPTY=
+            ExecStart=/bin/true
+            ExecReload=$EMPTY
+            ExecReload=$UNKNOWN
+            """)
+        cmd = "{systemctl} start zzb.service"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertEqual(end, 0)
+        self.assertFalse(greps(err, "Exec is not an absolute path"))
+        #
+        self.rm_testdir()
+        self.coverage()
+        self.end()
     def real_3250_nonlazy_expand_variables(self) -> None:
         self.test_3250_nonlazy_expand_variables(True)
     def test_3250_nonlazy_expand_variables(self, real:bool = False) -> None:
@@ -12336,6 +12530,128 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.rm_testdir()
         self.coverage()
         self.end()
+    def test_3905_start_notify_ready_without_sleeping(self) -> None:
+        """ check that a notify service is started as soon as it has sent READY
+            and MAINPID, and that a main process dying early is seen at once"""
+        vv = self.begin()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        testsleep = self.testname("sleep")
+        python = _python
+        bindir = os_path(root, "/usr/bin")
+        self.rm_testdir()
+        shell_file(os_path(testdir, "zza.py"),"""
+            #! {python}
+            import os, socket
+            sock = socket.socket(socket.AF_UNIX, socket.SOCK_DGRAM)
+            sock.sendto(("READY=1\\nMAINPID=%i\\n" % os.getpid()).encode("utf-8"), os.environ["NOTIFY_SOCKET"])
+            os.execv("{bindir}/{testsleep}", [ "{testsleep}", "99" ])
+            """.format(**locals()))
+        text_file(os_path(root, "/etc/systemd/system/zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=notify
+            ExecStart={bindir}/zza.py
+            TimeoutStartSec=30
+            """.format(**locals()))
+        text_file(os_path(root, "/etc/systemd/system/zzb.service"),"""
+            [Unit]
+            Description=Testing B
+            [Service]
+            Type=notify
+            ExecStart=/bin/sh -c "sleep 1; exit 1"
+            TimeoutStartSec=30
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleep))
+        copy_tool(os_path(testdir, "zza.py"), os_path(bindir, "zza.py"))
+        #
+        started = time.time()
+        cmd = "{systemctl} start zza.service {vv}"
+        out, end = output2(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s", cmd, end, out)
+        startA = time.time() - started
+        self.assertEqual(end, 0)
+        cmd = "{systemctl} show zza.service -p MainPID"
+        mainpid = output(cmd.format(**locals())).strip().split("=",1)[1]
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertTrue(greps(top, r"\b{mainpid}\b.*{testsleep} 99".format(**locals())))
+        #
+        started = time.time()
+        cmd = "{systemctl} start zzb.service {vv}"
+        out, end = output2(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s", cmd, end, out)
+        startB = time.time() - started
+        self.assertNotEqual(end, 0)
+        logg.info("start zza %.3fs zzb %.3fs", startA, startB)
+        self.assertLess(startA, startB) # no sleeping before the first read
+        self.assertLess(startB, 10.0) # not waiting for TimeoutStartSec
+        #
+        cmd = "{systemctl} stop zza.service {vv}"
+        sh____(cmd.format(**locals()))
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_3906_start_forking_pid_file_without_sleeping(self) -> None:
+        """ check that a forking service is started as soon as its PIDFile
+            was written, with inotify and with the polling fallback"""
+        vv = self.begin()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        testsleep = self.testname("sleep")
+        bindir = os_path(root, "/usr/bin")
+        pidfile = os_path(root, "/var/run/zza.pid")
+        self.rm_testdir()
+        shell_file(os_path(testdir, "zza.sh"),"""
+            #! /bin/sh
+            {bindir}/{testsleep} 99 0<&- >/dev/null 2>&1 &
+            daemon=$!
+            (sleep 0.3; echo $daemon > {pidfile}.tmp; mv {pidfile}.tmp {pidfile}) 0<&- >/dev/null 2>&1 &
+            exit 0
+            """.format(**locals()))
+        text_file(os_path(root, "/etc/systemd/system/zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=forking
+            PIDFile=/var/run/zza.pid
+            ExecStart={bindir}/zza.sh
+            TimeoutStartSec=30
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleep))
+        copy_tool(os_path(testdir, "zza.sh"), os_path(bindir, "zza.sh"))
+        os.makedirs(os_path(root, "/var/run"))
+        #
+        started = time.time()
+        cmd = "{systemctl} is-active zza.service"
+        out, end = output2(cmd.format(**locals()))
+        baseline = time.time() - started
+        self.assertEqual(out.strip(), "inactive")
+        for inotify in ["yes", "no"]:
+            started = time.time()
+            cmd = "{systemctl} start zza.service -c INOTIFY={inotify} -c MinimumYield=0 {vv}"
+            out, end = output2(cmd.format(**locals()))
+            logg.info(" %s =>%s\n%s", cmd, end, out)
+            elapsed = time.time() - started
+            self.assertEqual(end, 0)
+            mainpid = reads(pidfile).strip()
+            top = _recent(output(_top_list))
+            logg.info("\n>>>\n%s", top)
+            self.assertTrue(greps(top, r"\b{mainpid}\b.*{testsleep} 99".format(**locals())))
+            logg.info("start zza (INOTIFY=%s) %.3fs - baseline %.3fs", inotify, elapsed, baseline)
+            self.assertLess(elapsed, baseline + 0.8) # no checking in one second steps
+            #
+            cmd = "{systemctl} stop zza.service {vv}"
+            sh____(cmd.format(**locals()))
+            os_remove(pidfile)
+        self.rm_testdir()
+        self.coverage()
+        self.end()
     def real_3903_start_false_exec_oneshot(self) -> None:
         self.test_3903_start_false_exec_oneshot(True)
     def test_3903_start_false_exec_oneshot(self, real:bool = False) -> None:
@@ -16665,51 +16981,247 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.rm_testdir()
         self.coverage()
         self.end()
-    def real_4090_simple_service_RemainAfterExit(self) -> None:
-        self.test_4090_simple_service_RemainAfterExit(True)
-    def test_4090_simple_service_RemainAfterExit(self, real:bool = False) -> None:
-        """ check that we manage simple services in a root env
-            with commands like start, restart, stop, etc where
-            RemainAfterExit=yes says the service is okay even
-            when ExecStart has finished."""
+    def test_4080_boottime_cache_file(self) -> None:
+        """ check that the boot time is computed once and then
+            read from the cache file until the boot process changes."""
         self.begin()
         testname = self.testname()
         testdir = self.testdir()
         user = self.user()
-        root = self.root(testdir, real)
-        vv = "-vv"
+        root = self.root(testdir)
         systemctl = cover() + _systemctl_py + " --root=" + root
-        if real: vv, systemctl = "", "/usr/bin/systemctl"
-        testsleep = self.testname("testsleep")
-        testfail = self.testname("testfail.sh")
-        bindir = os_path(root, "/usr/bin")
         text_file(os_path(testdir, "zzz.service"),"""
             [Unit]
             Description=Testing Z
             [Service]
-            Type=simple
-            ExecStartPre=/bin/echo %n
-            ExecStart={bindir}/{testsleep} 20
-            ExecStartPost=/bin/echo started $MAINPID
-            ExecStop=/bin/kill $MAINPID
-            ExecStopPost=/bin/echo stopped $MAINPID
-            ExecStopPost=/bin/sleep 2
-            [Install]
-            WantedBy=multi-user.target
+            Type=oneshot
+            ExecStart=/bin/true
+            RemainAfterExit=yes
             """.format(**locals()))
-        text_file(os_path(testdir, "zze.service"),"""
+        copy_file(os_path(testdir, "zzz.service"), os_path(root, "/etc/systemd/system/zzz.service"))
+        os.makedirs(os_path(root, "/run"))
+        #
+        systemctl += " -c BOOT_PID_MIN=%s -c DEBUG_BOOTTIME" % (os.getpid())
+        cmd = "{systemctl} start zzz.service -vv"
+        sh____(cmd.format(**locals()))
+        cache_file = os_path(root, "/run/systemctl.boottime.cache")
+        self.assertTrue(os.path.exists(cache_file))
+        cached = reads(cache_file).split()
+        logg.info("cached %s", cached)
+        self.assertEqual(cached[0], "/proc/%s/stat" % os.getpid())
+        #
+        cmd = "{systemctl} is-active zzz.service -vvvv"
+        act, err, end = output3(cmd.format(**locals()))
+        self.assertEqual(act.strip(), "active")
+        self.assertTrue(greps(err, "cached boot time"))
+        self.assertFalse(greps(err, "System btime secs"))
+        #
+        text_file(cache_file, "/proc/%s/stat 1 1.0\n" % os.getpid())
+        act, err, end = output3(cmd.format(**locals()))
+        self.assertEqual(act.strip(), "active")
+        self.assertFalse(greps(err, "cached boot time"))
+        self.assertTrue(greps(err, "System btime secs"))
+        self.assertEqual(reads(cache_file).split(), ["/proc/%s/stat" % os.getpid(), "1", "1.0"]) # read-only
+        cmd = "{systemctl} restart zzz.service -vvvv"
+        act, err, end = output3(cmd.format(**locals()))
+        self.assertFalse(greps(err, "cached boot time"))
+        self.assertTrue(greps(err, "System btime secs"))
+        self.assertEqual(reads(cache_file).split(), cached)
+        #
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4081_read_only_commands_keep_old_status(self) -> None:
+        """ check that is-active does not truncate a status file from
+            before the boot time - only a command holding the lock does."""
+        self.begin()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        text_file(os_path(testdir, "zzz.service"),"""
             [Unit]
-            Description=Testing E
+            Description=Testing Z
             [Service]
-            Type=simple
-            ExecStartPre=/bin/echo %n
-            ExecStart={bindir}/{testsleep} 3
-            ExecStartPost=/bin/echo started $MAINPID
-            ExecStop=/bin/kill $MAINPID
-            ExecStopPost=/bin/echo stopped $MAINPID
-            ExecStopPost=/bin/sleep 2
-            [Install]
-            WantedBy=multi-user.target
+            Type=oneshot
+            ExecStart=/bin/true
+            RemainAfterExit=yes
+            """.format(**locals()))
+        copy_file(os_path(testdir, "zzz.service"), os_path(root, "/etc/systemd/system/zzz.service"))
+        cmd = "{systemctl} start zzz.service"
+        sh____(cmd.format(**locals()))
+        status_file = os_path(root, "/run/zzz.service.status")
+        self.assertTrue(greps(reads(status_file), "ActiveState"))
+        os.utime(status_file, (1000, 1000))  # long before the boot time
+        #
+        cmd = "{systemctl} is-active zzz.service"
+        out, end = output2(cmd.format(**locals()))
+        self.assertEqual(out.strip(), "inactive")
+        self.assertTrue(greps(reads(status_file), "ActiveState"))
+        cmd = "{systemctl} status zzz.service"
+        out, end = output2(cmd.format(**locals()))
+        self.assertTrue(greps(reads(status_file), "ActiveState"))
+        cmd = "{systemctl} start zzz.service"
+        sh____(cmd.format(**locals()))
+        cmd = "{systemctl} is-active zzz.service"
+        out, end = output2(cmd.format(**locals()))
+        self.assertEqual(out.strip(), "active")
+        #
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4082_status_files_are_written_atomically(self) -> None:
+        """ a concurrent reader never sees a half-written status file, and an
+            unchanged status is not written again by later calls """
+        self.begin()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        testsleep = self.testname("sleep")
+        bindir = os_path(root, "/usr/bin")
+        text_file(os_path(root, "/etc/systemd/system/zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleep} 99
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleep))
+        #
+        cmd = "{systemctl} start zza.service -vv"
+        sh____(cmd.format(**locals()))
+        status_file = os_path(root, "/run/zza.service.status")
+        self.assertTrue(os.path.exists(status_file))
+        st = os.stat(status_file)
+        for cmd in [ "{systemctl} start zza.service", "{systemctl} is-active zza.service", "{systemctl} status zza.service" ]:
+            sx____(cmd.format(**locals()))
+            st2 = os.stat(status_file)
+            self.assertEqual((st.st_ino, st.st_mtime), (st2.st_ino, st2.st_mtime))
+        #
+        seen: Dict[str, int] = {}
+        reading = threading.Event()
+        def reader() -> None:
+            while not reading.is_set():
+                try:
+                    text = open(status_file).read()
+                except IOError:
+                    text = "<missing>" # between stop and start
+                seen[text] = seen.get(text, 0) + 1
+        thread = threading.Thread(target=reader)
+        thread.start()
+        try:
+            for attempt in range(5):
+                cmd = "{systemctl} restart zza.service"
+                sh____(cmd.format(**locals()))
+        finally:
+            reading.set()
+            thread.join()
+        logg.info("seen %s", seen)
+        for text in seen:
+            if text != "<missing>":
+                self.assertTrue(re.match(r"^MainPID=\d+\n$", text), "torn %s" % repr(text))
+        self.assertGreaterEqual(len([ text for text in seen if text.startswith("MainPID=") ]), 5)
+        self.assertEqual([ name for name in os.listdir(os.path.dirname(status_file)) if name.endswith(".tmp") ], [])
+        #
+        cmd = "{systemctl} stop zza.service"
+        sh____(cmd.format(**locals()))
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4085_journal_log_lines_since_until(self) -> None:
+        """ check that 'systemctl log' reads the journal log itself, using
+            the journal index for --since and --until."""
+        self.begin()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        text_file(os_path(testdir, "zzz.service"),"""
+            [Unit]
+            Description=Testing Z
+            [Service]
+            Type=simple
+            ExecStart=/bin/sleep 9
+            """.format(**locals()))
+        copy_file(os_path(testdir, "zzz.service"), os_path(root, "/etc/systemd/system/zzz.service"))
+        cmd = "{systemctl} show zzz.service -p JournalFilePath"
+        journal = output(cmd.format(**locals())).strip().split("=",1)[1]
+        text = "".join(["line %i\n" % i for i in range(1, 10001)])
+        text_file(journal, text + "last line")
+        #
+        systemctl += " -c TAIL_CMD=/bin/false -c CAT_CMD=/bin/false"
+        cmd = "{systemctl} log zzz.service -n 3 --no-pager"
+        out = output(cmd.format(**locals()))
+        self.assertEqual(lines(out), ["line 9999", "line 10000", "last line"])
+        #
+        now = time.time()
+        first = text.index("line 101\n")
+        second = text.index("line 201\n")
+        text_file(journal + ".idx", "%.3f 0\n%.3f %i\n%.3f %i\n" % (now - 600, now - 300, first, now - 60, second))
+        cmd = "{systemctl} log zzz.service --since '-5min' --until '2 min ago'"
+        out = output(cmd.format(**locals()))
+        self.assertEqual(lines(out)[0], "line 101")
+        self.assertEqual(lines(out)[-1], "line 200")
+        cmd = "{systemctl} log zzz.service --since '-5min' --until '2 min ago' -n 1"
+        out = output(cmd.format(**locals()))
+        self.assertEqual(lines(out), ["line 200"])
+        cmd = "{systemctl} log zzz.service --since tomorrow"
+        out = output(cmd.format(**locals()))
+        self.assertEqual(lines(out), [])
+        cmd = "{systemctl} log zzz.service --since 'no such time'"
+        out, err, end = output3(cmd.format(**locals()))
+        self.assertTrue(greps(err, "Failed to parse timestamp"))
+        self.assertEqual(end, 1)
+        #
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def real_4090_simple_service_RemainAfterExit(self) -> None:
+        self.test_4090_simple_service_RemainAfterExit(True)
+    def test_4090_simple_service_RemainAfterExit(self, real:bool = False) -> None:
+        """ check that we manage simple services in a root env
+            with commands like start, restart, stop, etc where
+            RemainAfterExit=yes says the service is okay even
+            when ExecStart has finished."""
+        self.begin()
+        testname = self.testname()
+        testdir = self.testdir()
+        user = self.user()
+        root = self.root(testdir, real)
+        vv = "-vv"
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        if real: vv, systemctl = "", "/usr/bin/systemctl"
+        testsleep = self.testname("testsleep")
+        testfail = self.testname("testfail.sh")
+        bindir = os_path(root, "/usr/bin")
+        text_file(os_path(testdir, "zzz.service"),"""
+            [Unit]
+            Description=Testing Z
+            [Service]
+            Type=simple
+            ExecStartPre=/bin/echo %n
+            ExecStart={bindir}/{testsleep} 20
+            ExecStartPost=/bin/echo started $MAINPID
+            ExecStop=/bin/kill $MAINPID
+            ExecStopPost=/bin/echo stopped $MAINPID
+            ExecStopPost=/bin/sleep 2
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        text_file(os_path(testdir, "zze.service"),"""
+            [Unit]
+            Description=Testing E
+            [Service]
+            Type=simple
+            ExecStartPre=/bin/echo %n
+            ExecStart={bindir}/{testsleep} 3
+            ExecStartPost=/bin/echo started $MAINPID
+            ExecStop=/bin/kill $MAINPID
+            ExecStopPost=/bin/echo stopped $MAINPID
+            ExecStopPost=/bin/sleep 2
+            [Install]
+            WantedBy=multi-user.target
             """.format(**locals()))
         text_file(os_path(testdir, "zzf.service"),"""
             [Unit]
@@ -17223,6 +17735,149 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.rm_testdir()
         self.coverage()
         self.end()
+    def test_4106_systemctl_py_stop_in_process_exit_time(self) -> None:
+        """ check systemctl_py stop/restart to wait on the process exit only"""
+        self.begin()
+        testname = self.testname()
+        testdir = self.testdir()
+        user = self.user()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        testsleep = self.testname("sleep")
+        testsleepB = testsleep+"B"
+        testsleepC = testsleep+"C"
+        begin = "{"; ends = "}"
+        bindir = os_path(root, "/usr/bin")
+        rundir = os_path(root, "/var/run")
+        text_file(os_path(testdir, "zzb.service"),"""
+            [Unit]
+            Description=Testing B
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleepB} 99
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzc.service"),"""
+            [Unit]
+            Description=Testing C
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleepC} 111
+            ExecStop=/bin/kill ${begin}MAINPID{ends}
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepB))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepC))
+        copy_file(os_path(testdir, "zzb.service"), os_path(root, "/etc/systemd/system/zzb.service"))
+        copy_file(os_path(testdir, "zzc.service"), os_path(root, "/etc/systemd/system/zzc.service"))
+        os.makedirs(rundir)
+        #
+        cmd = "{systemctl} start zzb.service zzc.service -vv"
+        out, end = output2(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s", cmd, end, out)
+        self.assertEqual(end, 0)
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertTrue(greps(top, testsleepB))
+        self.assertTrue(greps(top, testsleepC))
+        #
+        cmd = "{systemctl} restart zzb.service -vv"
+        out, end = output2(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s", cmd, end, out)
+        self.assertEqual(end, 0)
+        cmd = "{systemctl} restart zzc.service -vv"
+        out, end = output2(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s", cmd, end, out)
+        self.assertEqual(end, 0)
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertTrue(greps(top, testsleepB))
+        self.assertTrue(greps(top, testsleepC))
+        #
+        started = time.time()
+        cmd = "{systemctl} stop zzb.service -vv"
+        out, end = output2(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s", cmd, end, out)
+        self.assertEqual(end, 0)
+        stopB = time.time() - started
+        started = time.time()
+        cmd = "{systemctl} stop zzc.service -vv"
+        out, end = output2(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s", cmd, end, out)
+        self.assertEqual(end, 0)
+        stopC = time.time() - started
+        logg.info("stop zzb %.3fs zzc %.3fs", stopB, stopC)
+        self.assertLess(stopB, 1.0) # no 1s polling anymore
+        self.assertLess(stopC, 1.0)
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertFalse(greps(top, testsleepB))
+        self.assertFalse(greps(top, testsleepC))
+        #
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4107_systemctl_py_stop_kills_the_children_of_the_main_pid(self) -> None:
+        """ check that stop finds the children of the main pid in one /proc snapshot"""
+        self.begin()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        systemctl += " -c CGROUP_TRACKING=no" # the pidlist_of the main pid
+        testsleep = self.testname("sleep")
+        testsleepA = testsleep+"A"
+        testsleepB = testsleep+"B"
+        testsleepC = testsleep+"C"
+        bindir = os_path(root, "/usr/bin")
+        shell_file(os_path(testdir, "zza.sh"),"""
+            #! /bin/sh
+            {bindir}/{testsleepB} 98 &
+            {bindir}/{testsleepC} 97 &
+            exec {bindir}/{testsleepA} 99
+            """.format(**locals()))
+        text_file(os_path(testdir, "zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=simple
+            ExecStart={bindir}/zza.sh
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepA))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepB))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepC))
+        copy_tool(os_path(testdir, "zza.sh"), os_path(bindir, "zza.sh"))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        #
+        cmd = "{systemctl} start zza.service -vv"
+        out, end = output2(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s", cmd, end, out)
+        self.assertEqual(end, 0)
+        time.sleep(1)
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertTrue(greps(top, testsleepA))
+        self.assertTrue(greps(top, testsleepB))
+        self.assertTrue(greps(top, testsleepC))
+        #
+        cmd = "{systemctl} stop zza.service -vv"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, out, err)
+        self.assertEqual(end, 0)
+        self.assertTrue(greps(err, r"stop control-group PIDs \[\d+, \d+, \d+\]"))
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertFalse(greps(top, testsleepA))
+        self.assertFalse(greps(top, testsleepB))
+        self.assertFalse(greps(top, testsleepC))
+        #
+        self.rm_testdir()
+        self.coverage()
+        self.end()
     def test_4120_systemctl_kill_ignore_behaviour(self) -> None:
         """ systemctl kill ignore behaviour"""
         self.begin()
@@ -18017,9 +18672,10 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.rm_testdir()
         self.coverage()
         self.end()
-    def test_4251_systemctl_py_dependencies_basic_reorder(self) -> None:
-        """ check list-dependencies - standard order of starting
-            units is simply the command line order (Before case)"""
+    def test_4221_systemctl_py_dependencies_parallel_start(self) -> None:
+        """ check that parallel start jobs do still respect
+            the After order while independent units run concurrently,
+            and that the parallel stop jobs go in the reverse order"""
         self.begin()
         testname = self.testname()
         testdir = self.testdir()
@@ -18032,7 +18688,7 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         text_file(os_path(testdir, "zza.service"),"""
             [Unit]
             Description=Testing A
-            Before=zzb.service
+            After=zzb.service
             [Service]
             Type=simple
             ExecStartPre={bindir}/logger 'start-A'
@@ -18055,7 +18711,7 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         text_file(os_path(testdir, "zzc.service"),"""
             [Unit]
             Description=Testing C
-            Before=zza.service
+            After=zza.service
             [Service]
             Type=simple
             ExecStartPre={bindir}/logger 'start-C'
@@ -18064,6 +18720,15 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
             [Install]
             WantedBy=multi-user.target
             """.format(**locals()))
+        text_file(os_path(testdir, "zzd.service"),"""
+            [Unit]
+            Description=Testing D
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleep} 122
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
         shell_file(os_path(testdir, "logger"),"""
             #! /bin/sh
             echo "$@" >> {logfile}
@@ -18075,16 +18740,249 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
         copy_file(os_path(testdir, "zzb.service"), os_path(root, "/etc/systemd/system/zzb.service"))
         copy_file(os_path(testdir, "zzc.service"), os_path(root, "/etc/systemd/system/zzc.service"))
+        copy_file(os_path(testdir, "zzd.service"), os_path(root, "/etc/systemd/system/zzd.service"))
         os.makedirs(os_path(root, "/var/run"))
         os.makedirs(os_path(root, "/var/log"))
         #
-        list_dependencies = "{systemctl} list-dependencies zza.service --now"
-        deps  = output(list_dependencies.format(**locals()))
-        logg.info("deps \n%s", deps)
-        #
-        cmd = "{systemctl} start zza.service zzb.service zzc.service -vv"
-        out, end = output2(cmd.format(**locals()))
-        logg.info(" %s =>%s\n%s", cmd, end, out)
+        cmd = "{systemctl} start zza.service zzb.service zzc.service zzd.service -vvv -c MaxParallelJobs=4"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, out, err)
+        self.assertEqual(end, 0)
+        self.assertTrue(greps(err, "job for zzd.service done [(]OK[)]"))
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertTrue(greps(top, testsleep+" 99"))
+        self.assertTrue(greps(top, testsleep+" 111"))
+        self.assertTrue(greps(top, testsleep+" 122"))
+        #
+        # inspect logfile
+        log = lines(open(logfile))
+        logg.info("logs \n| %s", "\n| ".join(log))
+        self.assertEqual(log[0], "start-B")
+        self.assertEqual(log[1], "start-A")
+        self.assertEqual(log[2], "start-C")
+        os.remove(logfile)
+        #
+        cmd = "{systemctl} stop zza.service zzb.service zzc.service zzd.service -vv -c MaxParallelJobs=4"
+        out, end = output2(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s", cmd, end, out)
+        self.assertEqual(end, 0)
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertFalse(greps(top, testsleep+" 99"))
+        self.assertFalse(greps(top, testsleep+" 122"))
+        #
+        # inspect logfile
+        log = lines(open(logfile))
+        logg.info("logs \n| %s", "\n| ".join(log))
+        self.assertEqual(log[0], "stop-C")
+        self.assertEqual(log[1], "stop-A")
+        self.assertEqual(log[2], "stop-B")
+        os.remove(logfile)
+        #
+        kill_testsleep = "{systemctl} __killall {testsleep}"
+        sx____(kill_testsleep.format(**locals()))
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4231_systemctl_py_dependencies_loop_reported(self) -> None:
+        """ check that a loop in the After/Before rules is reported
+            and broken up without dropping any of the units"""
+        self.begin()
+        testname = self.testname()
+        testdir = self.testdir()
+        user = self.user()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        logfile = os_path(root, "/var/log/"+testname+".log")
+        bindir = os_path(root, "/usr/bin")
+        text_file(os_path(testdir, "zza.service"),"""
+            [Unit]
+            Description=Testing A
+            After=zzc.service
+            [Service]
+            Type=oneshot
+            ExecStart={bindir}/logger 'start-A'
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzb.service"),"""
+            [Unit]
+            Description=Testing B
+            After=zza.service
+            [Service]
+            Type=oneshot
+            ExecStart={bindir}/logger 'start-B'
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzc.service"),"""
+            [Unit]
+            Description=Testing C
+            Before=zza.service
+            After=zzb.service
+            [Service]
+            Type=oneshot
+            ExecStart={bindir}/logger 'start-C'
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzd.service"),"""
+            [Unit]
+            Description=Testing D
+            Before=zza.service
+            [Service]
+            Type=oneshot
+            ExecStart={bindir}/logger 'start-D'
+            """.format(**locals()))
+        shell_file(os_path(testdir, "logger"),"""
+            #! /bin/sh
+            echo "$@" >> {logfile}
+            true
+            """.format(**locals()))
+        copy_tool(os_path(testdir, "logger"), os_path(bindir, "logger"))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        copy_file(os_path(testdir, "zzb.service"), os_path(root, "/etc/systemd/system/zzb.service"))
+        copy_file(os_path(testdir, "zzc.service"), os_path(root, "/etc/systemd/system/zzc.service"))
+        copy_file(os_path(testdir, "zzd.service"), os_path(root, "/etc/systemd/system/zzd.service"))
+        os.makedirs(os_path(root, "/var/run"))
+        os.makedirs(os_path(root, "/var/log"))
+        #
+        cmd = "{systemctl} start zzd.service zza.service zzb.service zzc.service -vv"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, out, err)
+        self.assertEqual(end, 0)
+        self.assertTrue(greps(err, "dependency loop in After/Before of zza.service zzb.service zzc.service"))
+        #
+        log = lines(open(logfile))
+        logg.info("logs \n| %s", "\n| ".join(log))
+        self.assertEqual(len(log), 4)
+        self.assertEqual(sorted(log), ["start-A", "start-B", "start-C", "start-D"])
+        self.assertLess(log.index("start-D"), log.index("start-A"))
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4241_systemctl_py_list_dependencies_of_a_loop(self) -> None:
+        """ check list-dependencies and the start dependencies on a Requires loop,
+            where each unit is looked up once and the recursion comes to an end"""
+        self.begin()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        text_file(os_path(root, "/etc/systemd/system/zza.service"),"""
+            [Unit]
+            Description=Testing A
+            Requires=zzb.service
+            [Service]
+            ExecStart=/bin/sleep 3
+            """)
+        text_file(os_path(root, "/etc/systemd/system/zzb.service"),"""
+            [Unit]
+            Description=Testing B
+            Requires=zzc.service
+            [Service]
+            ExecStart=/bin/sleep 3
+            """)
+        text_file(os_path(root, "/etc/systemd/system/zzc.service"),"""
+            [Unit]
+            Description=Testing C
+            Requires=zza.service
+            Wants=zzd.service
+            [Service]
+            ExecStart=/bin/sleep 3
+            """)
+        text_file(os_path(root, "/etc/systemd/system/zzd.service"),"""
+            [Unit]
+            Description=Testing D
+            [Service]
+            ExecStart=/bin/sleep 3
+            """)
+        #
+        cmd = "{systemctl} list-dependencies zza.service"
+        out, end = output2(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s", cmd, end, out)
+        self.assertEqual(end, 0)
+        self.assertEqual(lines(out), [
+            "zza.service:",
+            "| zzb.service: required to start",
+            "| | zzc.service: required to start",
+            "| | | zza.service: required to start",
+            "| | | zzd.service: wanted to start"])
+        cmd = "{systemctl} __get_start_dependencies zza.service"
+        out, end = output2(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s", cmd, end, out)
+        self.assertEqual(end, 0)
+        self.assertEqual(lines(out), [
+            "zzb.service=['Requires']",
+            "zzc.service=['Requires']",
+            "zzd.service=['Wants']"])
+        #
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4251_systemctl_py_dependencies_basic_reorder(self) -> None:
+        """ check list-dependencies - standard order of starting
+            units is simply the command line order (Before case)"""
+        self.begin()
+        testname = self.testname()
+        testdir = self.testdir()
+        user = self.user()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        logfile = os_path(root, "/var/log/"+testname+".log")
+        testsleep = self.testname("sleep")
+        bindir = os_path(root, "/usr/bin")
+        text_file(os_path(testdir, "zza.service"),"""
+            [Unit]
+            Description=Testing A
+            Before=zzb.service
+            [Service]
+            Type=simple
+            ExecStartPre={bindir}/logger 'start-A'
+            ExecStart={bindir}/{testsleep} 30
+            ExecStopPost={bindir}/logger 'stop-A'
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzb.service"),"""
+            [Unit]
+            Description=Testing B
+            [Service]
+            Type=simple
+            ExecStartPre={bindir}/logger 'start-B'
+            ExecStart={bindir}/{testsleep} 99
+            ExecStopPost={bindir}/logger 'stop-B'
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzc.service"),"""
+            [Unit]
+            Description=Testing C
+            Before=zza.service
+            [Service]
+            Type=simple
+            ExecStartPre={bindir}/logger 'start-C'
+            ExecStart={bindir}/{testsleep} 111
+            ExecStopPost={bindir}/logger 'stop-C'
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        shell_file(os_path(testdir, "logger"),"""
+            #! /bin/sh
+            echo "$@" >> {logfile}
+            cat {logfile} | sed -e "s|^| : |"
+            true
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleep))
+        copy_tool(os_path(testdir, "logger"), os_path(bindir, "logger"))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        copy_file(os_path(testdir, "zzb.service"), os_path(root, "/etc/systemd/system/zzb.service"))
+        copy_file(os_path(testdir, "zzc.service"), os_path(root, "/etc/systemd/system/zzc.service"))
+        os.makedirs(os_path(root, "/var/run"))
+        os.makedirs(os_path(root, "/var/log"))
+        #
+        list_dependencies = "{systemctl} list-dependencies zza.service --now"
+        deps  = output(list_dependencies.format(**locals()))
+        logg.info("deps \n%s", deps)
+        #
+        cmd = "{systemctl} start zza.service zzb.service zzc.service -vv"
+        out, end = output2(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s", cmd, end, out)
         self.assertEqual(end, 0)
         top = _recent(output(_top_list))
         logg.info("\n>>>\n%s", top)
@@ -19149,99 +20047,269 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.rm_testdir()
         self.coverage()
         self.end()
-    def test_4308_background_default_journal_null_stdout_stderr(self) -> None:
+    def test_4305_background_journal_pipes_rotated(self) -> None:
+        """ with JOURNAL_PIPES the init process writes the journal log from a fifo """
         self.begin()
         self.rm_testdir()
         self.rm_killall()
         testname = self.testname()
         testdir = self.testdir()
-        user = self.user()
         root = self.root(testdir)
         systemctl = cover() + _systemctl_py + " --root=" + root
-        logfile = os_path(root, "/var/log/"+testname+".log")
-        testsleepA = self.testname("sleepA")
-        testsleepB = self.testname("sleepB")
+        testsleep = self.testname("sleep")
         bindir = os_path(root, "/usr/bin")
-        shell_file(os_path(testdir, "testsleepA.bin"),"""
-            #! /bin/sh
-            echo starts testsleepA >&2
-            echo running testsleepA
-            exec {bindir}/{testsleepA} "$@"
-            """.format(**locals()))
-        shell_file(os_path(testdir, "testsleepB.bin"),"""
+        shell_file(os_path(testdir, "testsleep.bin"),"""
             #! /bin/sh
-            echo starts testsleepB >&2
-            echo running testsleepB
-            exec {bindir}/{testsleepB} "$@"
+            for i in 1 2 3 4 5 6 7 8 9; do echo running {testsleep} line $i; done
+            exec {bindir}/{testsleep} "$@"
             """.format(**locals()))
         text_file(os_path(testdir, "zza.service"),"""
             [Unit]
             Description=Testing A
             [Service]
             Type=simple
-            ExecStart={bindir}/{testsleepA}.bin 4
-            StandardOutput=null
-            StandardError=null
-            [Install]
-            WantedBy=multi-user.target
-            """.format(**locals()))
-        text_file(os_path(testdir, "zzb.service"),"""
-            [Unit]
-            Description=Testing B
-            [Service]
-            Type=simple
-            ExecStart={bindir}/{testsleepB}.bin 5
-            StandardOutput=null
-            StandardError=null
+            ExecStart={bindir}/{testsleep}.bin 9
             [Install]
             WantedBy=multi-user.target
             """.format(**locals()))
-        copy_tool(_bin_sleep, os_path(bindir, testsleepA))
-        copy_tool(_bin_sleep, os_path(bindir, testsleepB))
-        copy_tool(os_path(testdir, "testsleepA.bin"), os_path(bindir, testsleepA + ".bin"))
-        copy_tool(os_path(testdir, "testsleepB.bin"), os_path(bindir, testsleepB + ".bin"))
+        copy_tool(_bin_sleep, os_path(bindir, testsleep))
+        copy_tool(os_path(testdir, "testsleep.bin"), os_path(bindir, testsleep + ".bin"))
         copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
-        copy_file(os_path(testdir, "zzb.service"), os_path(root, "/etc/systemd/system/zzb.service"))
         cmd = "{systemctl} enable zza.service"
         sh____(cmd.format(**locals()))
-        cmd = "{systemctl} enable zzb.service"
-        sh____(cmd.format(**locals()))
         #
         InitLoopSleep = 1
         initsystemctl = systemctl
         initsystemctl += " -c InitLoopSleep={InitLoopSleep}".format(**locals())
-        if COVERAGE:
-            initsystemctl += " -c EXEC_SPAWN=True"
-        #
-        debug_log = os_path(root, expand_path(SYSTEMCTL_DEBUG_LOG))
-        os_remove(debug_log)
-        text_file(debug_log, "")
+        initsystemctl += " -c JOURNAL_PIPES=yes -c JournalLogMaxSize=100"
         cmd = "{initsystemctl} -1"
         init = background(cmd.format(**locals()))
         time.sleep(InitLoopSleep+1)
         #
-        top = _recent(output(_top_list))
-        logg.info("\n>>>\n%s", top)
-        self.assertTrue(greps(top, "systemctl.*InitLoopSleep"))
-        #
         cmd = "{systemctl} show zza.service -p JournalFilePath"
-        journal_a=output(cmd.format(**locals())).strip().split("=",1)[1]
-        cmd = "{systemctl} show zzb.service -p JournalFilePath"
-        journal_b=output(cmd.format(**locals())).strip().split("=",1)[1]
+        journal_a = output(cmd.format(**locals())).strip().split("=",1)[1]
         logg.info("journal zza = %s", journal_a)
-        logg.info("journal zzb = %s", journal_b)
-        time.sleep(1)
-        self.assertFalse(os.path.exists(journal_a))
-        self.assertFalse(os.path.exists(journal_b))
+        pipe_a = os_path(root, "/run/journal/zza.service.fifo")
+        self.assertTrue(os.path.exists(pipe_a))
+        self.assertTrue(os.path.exists(journal_a))
+        self.assertTrue(os.path.exists(journal_a + ".1"))
+        out_a = reads(journal_a + ".1") + reads(journal_a)
+        logg.info("out_a=%s", out_a.strip())
+        self.assertTrue(greps(out_a, "running .* line 1"))
+        self.assertTrue(greps(out_a, "running .* line 9"))
+        self.assertFalse(greps(out_a, "zza.service:"))
         #
         logg.info("kill daemon at %s", init.pid)
         self.assertTrue(self.kill(init.pid))
+        time.sleep(1)
+        self.assertFalse(os.path.exists(pipe_a))
         #
         self.rm_killall()
         self.rm_testdir()
         self.coverage()
         self.end()
-    def test_4309_background_default_journal_null_stdout_inherit(self) -> None:
+    def test_4306_background_control_socket(self) -> None:
+        """ the init process runs the start/stop/is-active calls of the control socket """
+        self.begin()
+        self.rm_testdir()
+        self.rm_killall()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        testsleepA = self.testname("sleepA")
+        testsleepB = self.testname("sleepB")
+        bindir = os_path(root, "/usr/bin")
+        text_file(os_path(testdir, "zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleepA} 99
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzb.service"),"""
+            [Unit]
+            Description=Testing B
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleepB} 111
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepA))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepB))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        copy_file(os_path(testdir, "zzb.service"), os_path(root, "/etc/systemd/system/zzb.service"))
+        cmd = "{systemctl} enable zza.service"
+        sh____(cmd.format(**locals()))
+        #
+        InitLoopSleep = 1
+        initsystemctl = systemctl
+        initsystemctl += " -c InitLoopSleep={InitLoopSleep}".format(**locals())
+        cmd = "{initsystemctl} -1"
+        init = background(cmd.format(**locals()))
+        time.sleep(InitLoopSleep+1)
+        control = os_path(root, "/run/systemd/systemctl.private")
+        self.assertTrue(os.path.exists(control))
+        #
+        cmd = "{systemctl} is-active zza.service zzb.service"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertEqual(lines(out), ["active", "inactive"])
+        self.assertEqual(end, 3)
+        cmd = "{systemctl} start zzb.service"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertEqual(end, 0)
+        cmd = "{systemctl} start zzc.service"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertTrue(greps(err, "ERROR:systemctl:Unit zzc.service not found."))
+        self.assertEqual(end, 5)
+        cmd = "{systemctl} show zzb.service -p ActiveState"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertEqual(lines(out), ["ActiveState=active"])
+        #
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertTrue(greps(top, testsleepA))
+        self.assertTrue(greps(top, testsleepB))
+        cmd = "{systemctl} show zzb.service -p MainPID"
+        mainpid = output(cmd.format(**locals())).strip().split("=",1)[1]
+        cmd = "ps -o ppid= -p {mainpid}"
+        ppid = output(cmd.format(**locals())).strip()
+        logg.info("PPID %s of %s (init %s)", ppid, mainpid, init.pid)
+        self.assertEqual(ppid, str(init.pid)) # started by the init process
+        #
+        cmd = "{systemctl} stop zzb.service"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertEqual(end, 0)
+        cmd = "{systemctl} is-active zzb.service"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertEqual(lines(out), ["inactive"])
+        self.assertEqual(end, 3)
+        text_file(os_path(root, "/etc/systemd/system/zzb.service"),"""
+            [Unit]
+            Description=Testing B again
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleepB} 111
+            """.format(**locals()))
+        cmd = "{systemctl} show zzb.service -p Description"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertEqual(lines(out), ["Description=Testing B again"])
+        #
+        logg.info("kill daemon at %s", init.pid)
+        self.assertTrue(self.kill(init.pid))
+        time.sleep(1)
+        self.assertFalse(os.path.exists(control))
+        cmd = "{systemctl} is-active zza.service"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertEqual(lines(out), ["inactive"])
+        #
+        self.rm_killall()
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4307_background_cgroup_tracking(self) -> None:
+        """ the init process starts the services in a cgroup of their own,
+            so that a double-forked process is stopped as well """
+        cgroup2 = ""
+        for folder in ["/sys/fs/cgroup", "/sys/fs/cgroup/unified"]:
+            if os.path.exists(os.path.join(folder, "cgroup.controllers")) and os.access(folder, os.W_OK):
+                cgroup2 = folder
+                break
+        if not cgroup2:
+            self.skipTest("no writable cgroup2")
+        self.begin()
+        self.rm_testdir()
+        self.rm_killall()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        cgroup = os.path.join(cgroup2, testname)
+        if not os.path.isdir(cgroup):
+            os.mkdir(cgroup)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        systemctl += " -c _cgroup_folder={cgroup} -c CGROUP_TRACKING=yes".format(**locals())
+        testsleepA = self.testname("sleepA")
+        testsleepB = self.testname("sleepB")
+        bindir = os_path(root, "/usr/bin")
+        text_file(os_path(testdir, "zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=simple
+            ExecStart=/bin/sh -c '({bindir}/{testsleepB} 111 &) ; exec {bindir}/{testsleepA} 99'
+            TasksMax=20
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepA))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepB))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        cmd = "{systemctl} enable zza.service"
+        sh____(cmd.format(**locals()))
+        #
+        InitLoopSleep = 1
+        initsystemctl = systemctl
+        initsystemctl += " -c InitLoopSleep={InitLoopSleep}".format(**locals())
+        cmd = "{initsystemctl} -1"
+        init = background(cmd.format(**locals()))
+        time.sleep(InitLoopSleep+1)
+        base = os_path(root, "/run/systemctl.cgroup")
+        if not os.path.exists(base):
+            self.kill(init.pid)
+            self.rm_killall()
+            os.rmdir(cgroup)
+            self.skipTest("no cgroup tracking in "+cgroup)
+        #
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertTrue(greps(top, testsleepA))
+        self.assertTrue(greps(top, testsleepB))
+        cmd = "{systemctl} show zza.service -p ControlGroup"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertTrue(greps(out, "ControlGroup=.*/zza.service"))
+        cmd = "{systemctl} -c CGROUP_TRACKING=no show zza.service -p ControlGroup"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertFalse(greps(out, "ControlGroup=.*/zza.service")) # the base file is ignored
+        cmd = "{systemctl} show zza.service -p TasksMax"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertEqual(lines(out), ["TasksMax=20"])
+        procs = reads(os.path.join(cgroup, "zza.service", "cgroup.procs"))
+        logg.info("cgroup.procs %s", procs.split())
+        self.assertEqual(len(procs.split()), 2)
+        #
+        cmd = "{systemctl} stop zza.service"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertEqual(end, 0)
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertFalse(greps(top, testsleepA))
+        self.assertFalse(greps(top, testsleepB)) # the double-forked one
+        self.assertFalse(os.path.isdir(os.path.join(cgroup, "zza.service")))
+        #
+        logg.info("kill daemon at %s", init.pid)
+        self.assertTrue(self.kill(init.pid))
+        time.sleep(1)
+        self.assertFalse(os.path.exists(base))
+        os.rmdir(cgroup)
+        #
+        self.rm_killall()
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4308_background_default_journal_null_stdout_stderr(self) -> None:
         self.begin()
         self.rm_testdir()
         self.rm_killall()
@@ -19273,6 +20341,7 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
             Type=simple
             ExecStart={bindir}/{testsleepA}.bin 4
             StandardOutput=null
+            StandardError=null
             [Install]
             WantedBy=multi-user.target
             """.format(**locals()))
@@ -19283,6 +20352,7 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
             Type=simple
             ExecStart={bindir}/{testsleepB}.bin 5
             StandardOutput=null
+            StandardError=null
             [Install]
             WantedBy=multi-user.target
             """.format(**locals()))
@@ -19331,7 +20401,7 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.rm_testdir()
         self.coverage()
         self.end()
-    def test_4311_background_logfile_journal(self) -> None:
+    def test_4309_background_default_journal_null_stdout_inherit(self) -> None:
         self.begin()
         self.rm_testdir()
         self.rm_killall()
@@ -19362,7 +20432,7 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
             [Service]
             Type=simple
             ExecStart={bindir}/{testsleepA}.bin 4
-            StandardOutput=file:{root}/var/log/zza.log
+            StandardOutput=null
             [Install]
             WantedBy=multi-user.target
             """.format(**locals()))
@@ -19372,7 +20442,7 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
             [Service]
             Type=simple
             ExecStart={bindir}/{testsleepB}.bin 5
-            StandardOutput=file:{root}/var/log/zzb.log
+            StandardOutput=null
             [Install]
             WantedBy=multi-user.target
             """.format(**locals()))
@@ -19413,32 +20483,85 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         time.sleep(1)
         self.assertFalse(os.path.exists(journal_a))
         self.assertFalse(os.path.exists(journal_b))
-        log_a = root + "/var/log/zza.log"
-        log_b = root + "/var/log/zzb.log"
-        logg.info("log zza = %s", log_a)
-        logg.info("log zzb = %s", log_b)
-        self.assertTrue(os.path.exists(log_a))
-        self.assertTrue(os.path.exists(log_b))
-        out_a = open(log_a).read()
-        out_b = open(log_b).read()
-        logg.info("out_a=%s", out_a.strip())
-        logg.info("out_b=%s", out_b.strip())
-        self.assertTrue(greps(out_a, "running testsleepA"))
-        self.assertTrue(greps(out_b, "running testsleepB"))
-        self.assertFalse(greps(out_a, "running testsleepB"))
-        self.assertFalse(greps(out_b, "running testsleepA"))
-        self.assertTrue(greps(out_a, "starts testsleepA"))
-        self.assertTrue(greps(out_b, "starts testsleepB"))
-        self.assertFalse(greps(out_a, "starts testsleepB"))
-        self.assertFalse(greps(out_b, "starts testsleepA"))
         #
         logg.info("kill daemon at %s", init.pid)
+        self.assertTrue(self.kill(init.pid))
         #
         self.rm_killall()
         self.rm_testdir()
         self.coverage()
         self.end()
-    def test_4312_background_logfile_journal(self) -> None:
+    def test_4310_background_metrics_textfile(self) -> None:
+        """ the init process rewrites a metrics textfile with the unit states and restarts """
+        self.begin()
+        self.rm_testdir()
+        self.rm_killall()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        testsleepA = self.testname("sleepA")
+        testsleepB = self.testname("sleepB")
+        bindir = os_path(root, "/usr/bin")
+        text_file(os_path(testdir, "zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleepA} 99
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzb.service"),"""
+            [Unit]
+            Description=Testing B
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleepB} 1
+            Restart=always
+            RestartSec=1
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepA))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepB))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        copy_file(os_path(testdir, "zzb.service"), os_path(root, "/etc/systemd/system/zzb.service"))
+        cmd = "{systemctl} enable zza.service zzb.service"
+        sh____(cmd.format(**locals()))
+        #
+        InitLoopSleep = 1
+        initsystemctl = systemctl
+        initsystemctl += " -c InitLoopSleep={InitLoopSleep} -c METRICS_TEXTFILE=yes -c MetricsIntervalSec=1".format(**locals())
+        cmd = "{initsystemctl} -1"
+        init = background(cmd.format(**locals()))
+        time.sleep(InitLoopSleep+5)
+        textfile = os_path(root, "/run/systemd/systemctl.prom")
+        metrics = lines(reads(textfile))
+        logg.info("%s\n%s", textfile, i2("\n".join(metrics)))
+        self.assertTrue(greps(metrics, '^systemctl_unit_state{unit="zza.service",state="active"} 1$'))
+        self.assertTrue(greps(metrics, '^systemctl_unit_state{unit="zza.service",state="failed"} 0$'))
+        self.assertTrue(greps(metrics, '^systemctl_unit_main_pid{unit="zza.service"} [1-9]'))
+        self.assertTrue(greps(metrics, '^systemctl_unit_processes{unit="zza.service"} 1$'))
+        self.assertTrue(greps(metrics, '^systemctl_unit_restarts_total{unit="zza.service"} 0$'))
+        self.assertTrue(greps(metrics, '^systemctl_unit_restarts_total{unit="zzb.service"} [1-9]'))
+        self.assertTrue(greps(metrics, '^systemctl_unit_start_seconds_count{unit="zza.service"} 1$'))
+        self.assertTrue(greps(metrics, '^systemctl_unit_start_seconds_count{unit="zzb.service"} [2-9]'))
+        self.assertTrue(greps(metrics, '^systemctl_unit_start_seconds_bucket{unit="zza.service",le="[+]Inf"} 1$'))
+        self.assertTrue(greps(metrics, '^systemctl_reaped_zombies_total [1-9]'))
+        self.assertTrue(greps(metrics, '^systemctl_init_loop_tick_seconds_count [1-9]'))
+        self.assertTrue(greps(metrics, '^# TYPE systemctl_unit_start_seconds histogram$'))
+        #
+        logg.info("kill daemon at %s", init.pid)
+        self.assertTrue(self.kill(init.pid))
+        time.sleep(1)
+        self.assertFalse(os.path.exists(textfile))
+        #
+        self.rm_killall()
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4311_background_logfile_journal(self) -> None:
         self.begin()
         self.rm_testdir()
         self.rm_killall()
@@ -19469,7 +20592,7 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
             [Service]
             Type=simple
             ExecStart={bindir}/{testsleepA}.bin 4
-            StandardError=file:{root}/var/log/zza.log
+            StandardOutput=file:{root}/var/log/zza.log
             [Install]
             WantedBy=multi-user.target
             """.format(**locals()))
@@ -19479,7 +20602,7 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
             [Service]
             Type=simple
             ExecStart={bindir}/{testsleepB}.bin 5
-            StandardError=file:{root}/var/log/zzb.log
+            StandardOutput=file:{root}/var/log/zzb.log
             [Install]
             WantedBy=multi-user.target
             """.format(**locals()))
@@ -19518,14 +20641,8 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         logg.info("journal zza = %s", journal_a)
         logg.info("journal zzb = %s", journal_b)
         time.sleep(1)
-        self.assertTrue(os.path.exists(journal_a))
-        self.assertTrue(os.path.exists(journal_b))
-        out_a = open(journal_a).read()
-        out_b = open(journal_b).read()
-        self.assertTrue(greps(out_a, "running testsleepA"))
-        self.assertTrue(greps(out_b, "running testsleepB"))
-        self.assertFalse(greps(out_a, "running testsleepB"))
-        self.assertFalse(greps(out_b, "running testsleepA"))
+        self.assertFalse(os.path.exists(journal_a))
+        self.assertFalse(os.path.exists(journal_b))
         log_a = root + "/var/log/zza.log"
         log_b = root + "/var/log/zzb.log"
         logg.info("log zza = %s", log_a)
@@ -19536,6 +20653,10 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         out_b = open(log_b).read()
         logg.info("out_a=%s", out_a.strip())
         logg.info("out_b=%s", out_b.strip())
+        self.assertTrue(greps(out_a, "running testsleepA"))
+        self.assertTrue(greps(out_b, "running testsleepB"))
+        self.assertFalse(greps(out_a, "running testsleepB"))
+        self.assertFalse(greps(out_b, "running testsleepA"))
         self.assertTrue(greps(out_a, "starts testsleepA"))
         self.assertTrue(greps(out_b, "starts testsleepB"))
         self.assertFalse(greps(out_a, "starts testsleepB"))
@@ -19547,7 +20668,7 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.rm_testdir()
         self.coverage()
         self.end()
-    def test_4313_background_logfile_journal(self) -> None:
+    def test_4312_background_logfile_journal(self) -> None:
         self.begin()
         self.rm_testdir()
         self.rm_killall()
@@ -19578,8 +20699,7 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
             [Service]
             Type=simple
             ExecStart={bindir}/{testsleepA}.bin 4
-            StandardOutput=file:{root}/var/log/zza.log
-            StandardError=journal
+            StandardError=file:{root}/var/log/zza.log
             [Install]
             WantedBy=multi-user.target
             """.format(**locals()))
@@ -19589,8 +20709,7 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
             [Service]
             Type=simple
             ExecStart={bindir}/{testsleepB}.bin 5
-            StandardOutput=file:{root}/var/log/zzb.log
-            StandardError=journal
+            StandardError=file:{root}/var/log/zzb.log
             [Install]
             WantedBy=multi-user.target
             """.format(**locals()))
@@ -19633,10 +20752,10 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.assertTrue(os.path.exists(journal_b))
         out_a = open(journal_a).read()
         out_b = open(journal_b).read()
-        self.assertTrue(greps(out_a, "starts testsleepA"))
-        self.assertTrue(greps(out_b, "starts testsleepB"))
-        self.assertFalse(greps(out_a, "starts testsleepB"))
-        self.assertFalse(greps(out_b, "starts testsleepA"))
+        self.assertTrue(greps(out_a, "running testsleepA"))
+        self.assertTrue(greps(out_b, "running testsleepB"))
+        self.assertFalse(greps(out_a, "running testsleepB"))
+        self.assertFalse(greps(out_b, "running testsleepA"))
         log_a = root + "/var/log/zza.log"
         log_b = root + "/var/log/zzb.log"
         logg.info("log zza = %s", log_a)
@@ -19647,14 +20766,546 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         out_b = open(log_b).read()
         logg.info("out_a=%s", out_a.strip())
         logg.info("out_b=%s", out_b.strip())
-        self.assertTrue(greps(out_a, "running testsleepA"))
+        self.assertTrue(greps(out_a, "starts testsleepA"))
+        self.assertTrue(greps(out_b, "starts testsleepB"))
+        self.assertFalse(greps(out_a, "starts testsleepB"))
+        self.assertFalse(greps(out_b, "starts testsleepA"))
+        #
+        logg.info("kill daemon at %s", init.pid)
+        #
+        self.rm_killall()
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4313_background_logfile_journal(self) -> None:
+        self.begin()
+        self.rm_testdir()
+        self.rm_killall()
+        testname = self.testname()
+        testdir = self.testdir()
+        user = self.user()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        logfile = os_path(root, "/var/log/"+testname+".log")
+        testsleepA = self.testname("sleepA")
+        testsleepB = self.testname("sleepB")
+        bindir = os_path(root, "/usr/bin")
+        shell_file(os_path(testdir, "testsleepA.bin"),"""
+            #! /bin/sh
+            echo starts testsleepA >&2
+            echo running testsleepA
+            exec {bindir}/{testsleepA} "$@"
+            """.format(**locals()))
+        shell_file(os_path(testdir, "testsleepB.bin"),"""
+            #! /bin/sh
+            echo starts testsleepB >&2
+            echo running testsleepB
+            exec {bindir}/{testsleepB} "$@"
+            """.format(**locals()))
+        text_file(os_path(testdir, "zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleepA}.bin 4
+            StandardOutput=file:{root}/var/log/zza.log
+            StandardError=journal
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzb.service"),"""
+            [Unit]
+            Description=Testing B
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleepB}.bin 5
+            StandardOutput=file:{root}/var/log/zzb.log
+            StandardError=journal
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepA))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepB))
+        copy_tool(os_path(testdir, "testsleepA.bin"), os_path(bindir, testsleepA + ".bin"))
+        copy_tool(os_path(testdir, "testsleepB.bin"), os_path(bindir, testsleepB + ".bin"))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        copy_file(os_path(testdir, "zzb.service"), os_path(root, "/etc/systemd/system/zzb.service"))
+        cmd = "{systemctl} enable zza.service"
+        sh____(cmd.format(**locals()))
+        cmd = "{systemctl} enable zzb.service"
+        sh____(cmd.format(**locals()))
+        #
+        InitLoopSleep = 1
+        initsystemctl = systemctl
+        initsystemctl += " -c InitLoopSleep={InitLoopSleep}".format(**locals())
+        if COVERAGE:
+            initsystemctl += " -c EXEC_SPAWN=True"
+        #
+        debug_log = os_path(root, expand_path(SYSTEMCTL_DEBUG_LOG))
+        os_remove(debug_log)
+        text_file(debug_log, "")
+        cmd = "{initsystemctl} -1"
+        init = background(cmd.format(**locals()))
+        time.sleep(InitLoopSleep+1)
+        #
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertTrue(greps(top, "systemctl.*InitLoopSleep"))
+        #
+        cmd = "{systemctl} show zza.service -p JournalFilePath"
+        journal_a=output(cmd.format(**locals())).strip().split("=",1)[1]
+        cmd = "{systemctl} show zzb.service -p JournalFilePath"
+        journal_b=output(cmd.format(**locals())).strip().split("=",1)[1]
+        logg.info("journal zza = %s", journal_a)
+        logg.info("journal zzb = %s", journal_b)
+        time.sleep(1)
+        self.assertTrue(os.path.exists(journal_a))
+        self.assertTrue(os.path.exists(journal_b))
+        out_a = open(journal_a).read()
+        out_b = open(journal_b).read()
+        self.assertTrue(greps(out_a, "starts testsleepA"))
+        self.assertTrue(greps(out_b, "starts testsleepB"))
+        self.assertFalse(greps(out_a, "starts testsleepB"))
+        self.assertFalse(greps(out_b, "starts testsleepA"))
+        log_a = root + "/var/log/zza.log"
+        log_b = root + "/var/log/zzb.log"
+        logg.info("log zza = %s", log_a)
+        logg.info("log zzb = %s", log_b)
+        self.assertTrue(os.path.exists(log_a))
+        self.assertTrue(os.path.exists(log_b))
+        out_a = open(log_a).read()
+        out_b = open(log_b).read()
+        logg.info("out_a=%s", out_a.strip())
+        logg.info("out_b=%s", out_b.strip())
+        self.assertTrue(greps(out_a, "running testsleepA"))
         self.assertTrue(greps(out_b, "running testsleepB"))
         self.assertFalse(greps(out_a, "running testsleepB"))
         self.assertFalse(greps(out_b, "running testsleepA"))
         #
         logg.info("kill daemon at %s", init.pid)
         self.assertTrue(self.kill(init.pid))
-        #
+        #
+        self.rm_killall()
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4314_background_reap_zombies_on_sigchld(self) -> None:
+        """ the init process reaps an exited main process at once, not on the next tick """
+        self.begin()
+        self.rm_testdir()
+        self.rm_killall()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        testsleepA = self.testname("sleepA")
+        testsleepB = self.testname("sleepB")
+        bindir = os_path(root, "/usr/bin")
+        text_file(os_path(testdir, "zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleepA} 2
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzb.service"),"""
+            [Unit]
+            Description=Testing B
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleepB} 99
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepA))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepB))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        copy_file(os_path(testdir, "zzb.service"), os_path(root, "/etc/systemd/system/zzb.service"))
+        cmd = "{systemctl} enable zza.service zzb.service"
+        sh____(cmd.format(**locals()))
+        #
+        InitLoopSleep = 10
+        initsystemctl = systemctl
+        initsystemctl += " -c InitLoopSleep={InitLoopSleep}".format(**locals())
+        debug_log = os_path(root, expand_path(SYSTEMCTL_DEBUG_LOG))
+        os_remove(debug_log)
+        text_file(debug_log, "")
+        cmd = "{initsystemctl} -1"
+        init = background(cmd.format(**locals()))
+        time.sleep(1)
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertTrue(greps(top, testsleepA))
+        self.assertTrue(greps(top, testsleepB))
+        time.sleep(3) # zza has exited after 2s - long before the next InitLoopSleep tick
+        cmd = "ps -eo pid,ppid,stat,args"
+        top = output(cmd.format(**locals()))
+        logg.info("\n>>>\n%s", top)
+        self.assertFalse(greps(top, testsleepA))
+        self.assertFalse(greps(top, r"\bZ.*{testname}".format(**locals())))
+        self.assertTrue(greps(top, testsleepB))
+        log = lines(open(debug_log))
+        self.assertTrue(greps(log, "reap zombie"))
+        #
+        logg.info("kill daemon at %s", init.pid)
+        self.assertTrue(self.kill(init.pid))
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertFalse(greps(top, testsleepB))
+        #
+        self.rm_killall()
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4315_background_log_forwarder(self) -> None:
+        """ the init process forwards the journal lines at once, not on the next tick,
+            and every line is forwarded only once"""
+        self.begin()
+        self.rm_testdir()
+        self.rm_killall()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        testsleep = self.testname("sleep")
+        bindir = os_path(root, "/usr/bin")
+        shell_file(os_path(testdir, "testsleep.bin"),"""
+            #! /bin/sh
+            echo running {testsleep} line 1
+            sleep 2
+            printf "running {testsleep} line 2\\nrunning {testsleep} "
+            sleep 1
+            echo line 3
+            exec {bindir}/{testsleep} "$@"
+            """.format(**locals()))
+        text_file(os_path(testdir, "zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleep}.bin 99
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleep))
+        copy_tool(os_path(testdir, "testsleep.bin"), os_path(bindir, testsleep + ".bin"))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        cmd = "{systemctl} enable zza.service"
+        sh____(cmd.format(**locals()))
+        #
+        InitLoopSleep = 10
+        initsystemctl = systemctl
+        initsystemctl += " -c InitLoopSleep={InitLoopSleep}".format(**locals())
+        initout = os_path(testdir, "init.out")
+        cmd = "sh -c 'exec {initsystemctl} -1 > {initout}'"
+        init = background(cmd.format(**locals()))
+        time.sleep(1)
+        out = reads(initout)
+        logg.info("init.out>\n%s", out)
+        self.assertTrue(greps(out, r"^zza.service: running .* line 1$"))
+        self.assertFalse(greps(out, r"line 2"))
+        time.sleep(2) # zza has written line 2 after 2s - long before the next InitLoopSleep tick
+        out = reads(initout)
+        logg.info("init.out>\n%s", out)
+        self.assertTrue(greps(out, r"^zza.service: running .* line 2$"))
+        self.assertFalse(greps(out, r"line 3")) # the partial line is held back
+        time.sleep(1)
+        out = reads(initout)
+        logg.info("init.out>\n%s", out)
+        self.assertTrue(greps(out, r"^zza.service: running .* line 3$"))
+        #
+        logg.info("kill daemon at %s", init.pid)
+        self.assertTrue(self.kill(init.pid))
+        out = reads(initout)
+        logg.info("init.out>\n%s", out)
+        self.assertEqual(len(greps(out, r"^zza.service: running .* line 1$")), 1)
+        self.assertEqual(len(greps(out, r"^zza.service: running .* line 2$")), 1)
+        self.assertEqual(len(greps(out, r"^zza.service: running .* line 3$")), 1)
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertFalse(greps(top, testsleep))
+        #
+        self.rm_killall()
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4316_background_parallel_stop_at_exit(self) -> None:
+        """ the init process stops the independent services concurrently at the end """
+        self.begin()
+        self.rm_testdir()
+        self.rm_killall()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        testsleep = self.testname("sleep")
+        bindir = os_path(root, "/usr/bin")
+        for zz in ["zza", "zzb", "zzc"]:
+            text_file(os_path(root, "/etc/systemd/system/{zz}.service".format(**locals())),"""
+                [Unit]
+                Description=Testing {zz}
+                [Service]
+                Type=simple
+                ExecStart={bindir}/{testsleep} 99
+                ExecStop=/bin/sh -c "sleep 2; kill $MAINPID"
+                [Install]
+                WantedBy=multi-user.target
+                """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleep))
+        cmd = "{systemctl} enable zza.service zzb.service zzc.service"
+        sh____(cmd.format(**locals()))
+        #
+        InitLoopSleep = 1
+        initsystemctl = systemctl
+        initsystemctl += " -c InitLoopSleep={InitLoopSleep}".format(**locals())
+        cmd = "{initsystemctl} -1"
+        init = background(cmd.format(**locals()))
+        time.sleep(InitLoopSleep+1)
+        for attempt in xrange(20):
+            cmd = "{systemctl} is-system-running"
+            if output(cmd.format(**locals())).strip() == "running": break
+            time.sleep(0.5) # the init-loop has its signal handlers now
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertEqual(len(greps(top, testsleep + " 99")), 3)
+        #
+        logg.info("stop daemon at %s", init.pid)
+        started = time.time()
+        os.kill(init.pid, signal.SIGTERM)
+        for attempt in xrange(100):
+            if init.run.poll() is not None: break
+            time.sleep(0.1)
+        stopped = time.time() - started
+        logg.info("stopped init after %.3fs", stopped)
+        self.assertIsNotNone(init.run.poll())
+        self.assertLess(stopped, 5.0) # not 3 * 2s one after the other
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertFalse(greps(top, testsleep))
+        #
+        self.rm_killall()
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4317_background_control_socket_failing_start(self) -> None:
+        """ a failing start through the control socket is reported as failed,
+            with its warnings, and no forked copy of PID-1 is left over"""
+        self.begin()
+        self.rm_testdir()
+        self.rm_killall()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        testsleepA = self.testname("sleepA")
+        testsleepB = self.testname("sleepB")
+        bindir = os_path(root, "/usr/bin")
+        text_file(os_path(root, "/etc/systemd/system/zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleepA} 99
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        text_file(os_path(root, "/etc/systemd/system/zzb.service"),"""
+            [Unit]
+            Description=Testing B
+            [Service]
+            Type=simple
+            WorkingDirectory=/nonexistent
+            ExecStart={bindir}/{testsleepB} 111
+            """.format(**locals()))
+        text_file(os_path(root, "/etc/systemd/system/zzc.service"),"""
+            [Unit]
+            Description=Testing C
+            [Service]
+            Type=oneshot
+            WorkingDirectory=/nonexistent
+            ExecStart={bindir}/{testsleepB} 1
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepA))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepB))
+        cmd = "{systemctl} enable zza.service"
+        sh____(cmd.format(**locals()))
+        #
+        InitLoopSleep = 1
+        initsystemctl = systemctl
+        initsystemctl += " -c InitLoopSleep={InitLoopSleep}".format(**locals())
+        cmd = "{initsystemctl} -1"
+        init = background(cmd.format(**locals()))
+        time.sleep(InitLoopSleep+1)
+        control = os_path(root, "/run/systemd/systemctl.private")
+        self.assertTrue(os.path.exists(control))
+        #
+        cmd = "{systemctl} start zzb.service"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertNotEqual(end, 0)
+        self.assertTrue(greps(err, "WARNING:systemctl:simple start not active"))
+        cmd = "{systemctl} is-active zzb.service"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertEqual(lines(out), ["failed"])
+        cmd = "{systemctl} start zzc.service"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertNotEqual(end, 0)
+        self.assertTrue(greps(err, "ERROR:systemctl:oneshot start failed"))
+        cmd = "{systemctl} is-active zzc.service"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertEqual(lines(out), ["failed"])
+        #
+        cmd = "ps -eo pid,args"
+        top = output(cmd.format(**locals()))
+        logg.info("\n>>>\n%s", top)
+        procs = greps(top, r"^ *\d+ .*systemctl3?.py --root={root} -c InitLoopSleep".format(**locals()))
+        self.assertEqual(len(procs), 1) # only the init process
+        self.assertFalse(greps(top, testsleepB))
+        cmd = "{systemctl} is-active zza.service"
+        out, err, end = output3(cmd.format(**locals()))
+        logg.info(" %s =>%s\n%s\n%s", cmd, end, err, out)
+        self.assertEqual(lines(out), ["active"])
+        self.assertEqual(err, "")
+        #
+        logg.info("kill daemon at %s", init.pid)
+        self.assertTrue(self.kill(init.pid))
+        self.rm_killall()
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4318_background_journal_pipes_drained_at_stop(self) -> None:
+        """ with JOURNAL_PIPES and no LOG_FORWARDER the fifos are still read while
+            the units are stopped - a service logging a lot on SIGTERM does not block """
+        self.begin()
+        self.rm_testdir()
+        self.rm_killall()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        testsleep = self.testname("sleep")
+        bindir = os_path(root, "/usr/bin")
+        shell_file(os_path(testdir, "testsleep.bin"),"""
+            #! /bin/sh
+            stopping() {{
+              i=0; while [ $i -lt 3000 ]; do echo "stopping {testsleep} line $i ........................................"; i=$((i+1)); done
+              echo "stopped {testsleep}"; exit 0
+            }}
+            trap stopping TERM
+            echo "running {testsleep}"
+            while true; do {bindir}/{testsleep} 1; done
+            """.format(**locals()))
+        text_file(os_path(testdir, "zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=simple
+            KillMode=process
+            ExecStart={bindir}/{testsleep}.bin
+            TimeoutStopSec=20
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleep))
+        copy_tool(os_path(testdir, "testsleep.bin"), os_path(bindir, testsleep + ".bin"))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        cmd = "{systemctl} enable zza.service"
+        sh____(cmd.format(**locals()))
+        #
+        InitLoopSleep = 1
+        initsystemctl = systemctl
+        initsystemctl += " -c InitLoopSleep={InitLoopSleep}".format(**locals())
+        initsystemctl += " -c JOURNAL_PIPES=yes -c LOG_FORWARDER=no"
+        cmd = "{initsystemctl} -1"
+        init = background(cmd.format(**locals()))
+        time.sleep(InitLoopSleep+1)
+        #
+        cmd = "{systemctl} show zza.service -p JournalFilePath"
+        journal_a = output(cmd.format(**locals())).strip().split("=",1)[1]
+        logg.info("journal zza = %s", journal_a)
+        #
+        logg.info("kill daemon at %s", init.pid)
+        started = time.time()
+        self.assertTrue(self.kill(init.pid, 15, signal.SIGTERM))
+        stopped = time.time() - started
+        logg.info("init stopped after %.3fs", stopped)
+        self.assertLess(stopped, 12.0)
+        out_a = reads(journal_a)
+        self.assertTrue(greps(out_a, "stopping .* line 2999"))
+        self.assertTrue(greps(out_a, "stopped "))
+        #
+        self.rm_killall()
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4319_background_control_socket_concurrent_requests(self) -> None:
+        """ an is-active through the control socket is answered while a start
+            of another control request is still waiting for its unit """
+        self.begin()
+        self.rm_testdir()
+        self.rm_killall()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        testsleepA = self.testname("sleepA")
+        testsleepB = self.testname("sleepB")
+        bindir = os_path(root, "/usr/bin")
+        text_file(os_path(root, "/etc/systemd/system/zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleepA} 99
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        text_file(os_path(root, "/etc/systemd/system/zzb.service"),"""
+            [Unit]
+            Description=Testing B
+            [Service]
+            Type=notify
+            ExecStart={bindir}/{testsleepB} 111
+            TimeoutStartSec=8
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepA))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepB))
+        cmd = "{systemctl} enable zza.service"
+        sh____(cmd.format(**locals()))
+        #
+        InitLoopSleep = 1
+        initsystemctl = systemctl
+        initsystemctl += " -c InitLoopSleep={InitLoopSleep}".format(**locals())
+        cmd = "{initsystemctl} -1"
+        init = background(cmd.format(**locals()))
+        time.sleep(InitLoopSleep+1)
+        control = os_path(root, "/run/systemd/systemctl.private")
+        self.assertTrue(os.path.exists(control))
+        #
+        cmd = "{systemctl} start zzb.service"
+        start = background(cmd.format(**locals()))
+        time.sleep(2)
+        self.assertIsNone(start.run.poll()) # waiting for the notify
+        cmd = "{systemctl} is-active zza.service"
+        started = time.time()
+        out, err, end = output3(cmd.format(**locals()))
+        replied = time.time() - started
+        logg.info(" %s =>%s (%.3fs)\n%s\n%s", cmd, end, replied, err, out)
+        self.assertEqual(lines(out), ["active"])
+        self.assertLess(replied, 3.0)
+        self.assertIsNone(start.run.poll()) # still waiting
+        for attempt in xrange(20):
+            if start.run.poll() is not None: break
+            time.sleep(0.5)
+        self.assertIsNotNone(start.run.poll())
+        #
+        logg.info("kill daemon at %s", init.pid)
+        self.assertTrue(self.kill(init.pid))
         self.rm_killall()
         self.rm_testdir()
         self.coverage()
@@ -21427,6 +23078,144 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.rm_testdir()
         self.coverage()
         self.end()
+    def test_4415_socket_accept_instances(self) -> None:
+        """ check that Accept=yes spawns a name@instance.service for
+            each connection - and that MaxConnections is checked."""
+        self.begin()
+        self.rm_testdir()
+        self.rm_killall()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        sockfile = os_path(root, "/var/run/"+testname+".sock")
+        bindir = os_path(root, "/usr/bin")
+        shell_file(os_path(bindir, "zzb.sh"),"""
+            #! /bin/sh
+            read x
+            echo "$x for $1 ($LISTEN_FDS)"
+            sleep 2
+            """.format(**locals()))
+        text_file(os_path(root, "/etc/systemd/system/zzb@.service"),"""
+            [Unit]
+            Description=Testing B
+            [Service]
+            ExecStart={bindir}/zzb.sh %i
+            StandardInput=socket
+            """.format(**locals()))
+        text_file(os_path(root, "/etc/systemd/system/zzb.socket"),"""
+            [Unit]
+            Description=Testing B
+            [Socket]
+            Accept=yes
+            ListenStream={sockfile}
+            MaxConnections=1
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        cmd = "{systemctl} enable zzb.socket"
+        sh____(cmd.format(**locals()))
+        #
+        InitLoopSleep = 1
+        initsystemctl = systemctl
+        initsystemctl += " -c InitLoopSleep={InitLoopSleep}".format(**locals())
+        cmd = "{initsystemctl} -1"
+        init = background(cmd.format(**locals()))
+        time.sleep(InitLoopSleep+1)
+        #
+        cmd = "{systemctl} is-active zzb.socket"
+        out, end = output2(cmd.format(**locals()))
+        self.assertEqual(out.strip(), "active")
+        cmd = "./reply.py sendUNIX -d foo -f {sockfile}"
+        out, end = output2(cmd.format(**locals()))
+        logg.info("send.log>>\n%s", out)
+        self.assertTrue(greps(out, "replied: foo for 0-.* [(]1[)]"))
+        out, end = output2(cmd.format(**locals()))
+        logg.info("send.log>>\n%s", out)
+        self.assertFalse(greps(out, "replied: foo"))
+        time.sleep(3)
+        out, end = output2(cmd.format(**locals()))
+        logg.info("send.log>>\n%s", out)
+        self.assertTrue(greps(out, "replied: foo for 2-"))
+        #
+        logg.info("kill daemon at %s", init.pid)
+        self.assertTrue(self.kill(init.pid))
+        #
+        self.rm_killall()
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4416_socket_accept_without_ticks(self) -> None:
+        """ check that the listen thread accepts a connection as soon as it
+            comes in (not on the next InitLoopSleep tick) - and that the
+            init process stops promptly while the listen thread is blocking."""
+        self.begin()
+        self.rm_testdir()
+        self.rm_killall()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        sockfile = os_path(root, "/var/run/"+testname+".sock")
+        bindir = os_path(root, "/usr/bin")
+        shell_file(os_path(bindir, "zzb.sh"),"""
+            #! /bin/sh
+            read x
+            echo "$x for $1 ($LISTEN_FDS)"
+            """.format(**locals()))
+        text_file(os_path(root, "/etc/systemd/system/zzb@.service"),"""
+            [Unit]
+            Description=Testing B
+            [Service]
+            ExecStart={bindir}/zzb.sh %i
+            StandardInput=socket
+            """.format(**locals()))
+        text_file(os_path(root, "/etc/systemd/system/zzb.socket"),"""
+            [Unit]
+            Description=Testing B
+            [Socket]
+            Accept=yes
+            ListenStream={sockfile}
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        cmd = "{systemctl} enable zzb.socket"
+        sh____(cmd.format(**locals()))
+        #
+        InitLoopSleep = 10
+        initsystemctl = systemctl
+        initsystemctl += " -c InitLoopSleep={InitLoopSleep}".format(**locals())
+        cmd = "{initsystemctl} -1"
+        init = background(cmd.format(**locals()))
+        for attempt in xrange(20):
+            if os.path.exists(sockfile): break
+            time.sleep(0.5)
+        time.sleep(1)
+        #
+        cmd = "./reply.py sendUNIX -d foo -f {sockfile}"
+        for attempt in xrange(3):
+            started = time.time()
+            out, end = output2(cmd.format(**locals()))
+            replied = time.time() - started
+            logg.info("send.log>> (%.3fs)\n%s", replied, out)
+            self.assertTrue(greps(out, "replied: foo for .* [(]1[)]"))
+            self.assertLess(replied, InitLoopSleep / 2)
+        #
+        logg.info("stop daemon at %s", init.pid)
+        started = time.time()
+        os.kill(init.pid, signal.SIGTERM)
+        for attempt in xrange(100):
+            if init.run.poll() is not None: break
+            time.sleep(0.1)
+        stopped = time.time() - started
+        logg.info("stopped init after %.3fs", stopped)
+        self.assertIsNotNone(init.run.poll())
+        self.assertLess(stopped, InitLoopSleep / 2)
+        #
+        self.rm_killall()
+        self.rm_testdir()
+        self.coverage()
+        self.end()
     def test_4417_stop_post_socket_accept(self) -> None:
         self.begin()
         self.rm_testdir()
@@ -21657,6 +23446,96 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.rm_testdir()
         self.coverage()
         self.end()
+    def test_4419_socket_accept_instance_units(self) -> None:
+        """ check that an Accept=yes instance is started like any other unit, that
+            is with ExecStartPre and a status file, and that it is stopped with
+            its ExecStopPost after it has exited - and that an overflow is logged."""
+        self.begin()
+        self.rm_testdir()
+        self.rm_killall()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        sockfile = os_path(root, "/var/run/"+testname+".sock")
+        logfile = os_path(root, "/var/log/"+testname+".log")
+        bindir = os_path(root, "/usr/bin")
+        shell_file(os_path(bindir, "zzb.sh"),"""
+            #! /bin/sh
+            read x
+            echo "$x for $1 ($LISTEN_FDS)"
+            sleep 3
+            """.format(**locals()))
+        text_file(os_path(root, "/etc/systemd/system/zzb@.service"),"""
+            [Unit]
+            Description=Testing B
+            [Service]
+            ExecStartPre=/bin/sh -c "echo pre %i >> {logfile}"
+            ExecStart={bindir}/zzb.sh %i
+            ExecStopPost=/bin/sh -c "echo post %i >> {logfile}"
+            StandardInput=socket
+            """.format(**locals()))
+        text_file(os_path(root, "/etc/systemd/system/zzb.socket"),"""
+            [Unit]
+            Description=Testing B
+            [Socket]
+            Accept=yes
+            ListenStream={sockfile}
+            MaxConnections=1
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        cmd = "{systemctl} enable zzb.socket"
+        sh____(cmd.format(**locals()))
+        #
+        debug_log = os_path(root, expand_path(SYSTEMCTL_DEBUG_LOG))
+        os_remove(debug_log)
+        text_file(debug_log, "")
+        InitLoopSleep = 1
+        initsystemctl = systemctl
+        initsystemctl += " -c InitLoopSleep={InitLoopSleep}".format(**locals())
+        cmd = "{initsystemctl} -1"
+        init = background(cmd.format(**locals()))
+        for attempt in xrange(20):
+            if os.path.exists(sockfile): break
+            time.sleep(0.5)
+        time.sleep(1)
+        #
+        cmd = "./reply.py sendUNIX -d foo -f {sockfile}"
+        out, end = output2(cmd.format(**locals()))
+        logg.info("send.log>>\n%s", out)
+        self.assertTrue(greps(out, "replied: foo for 0-.* [(]1[)]"))
+        instance = out.split("replied: foo for ", 1)[1].split(" ", 1)[0]
+        unit = "zzb@{instance}.service".format(**locals())
+        cmd = "{systemctl} is-active {unit}"
+        out, end = output2(cmd.format(**locals()))
+        logg.info("is-active %s>> %s", unit, out)
+        self.assertEqual(out.strip(), "active")
+        cmd = "./reply.py sendUNIX -d bar -f {sockfile}"
+        out, end = output2(cmd.format(**locals()))
+        logg.info("send.log>>\n%s", out)
+        self.assertFalse(greps(out, "replied: bar"))
+        for attempt in xrange(20):
+            time.sleep(0.5)
+            if greps(reads(logfile), "post "): break
+        log = reads(logfile)
+        logg.info("%s>>\n%s", logfile, log)
+        self.assertTrue(greps(log, "pre {instance}".format(**locals())))
+        self.assertTrue(greps(log, "post {instance}".format(**locals())))
+        cmd = "{systemctl} is-active {unit}"
+        out, end = output2(cmd.format(**locals()))
+        logg.info("is-active %s>> %s", unit, out)
+        self.assertNotEqual(out.strip(), "active")
+        oo = reads(debug_log)
+        self.assertTrue(greps(oo, "WARNING zzb.socket: too many incoming connections [(]1[)]"))
+        #
+        logg.info("kill daemon at %s", init.pid)
+        self.assertTrue(self.kill(init.pid))
+        #
+        self.rm_killall()
+        self.rm_testdir()
+        self.coverage()
+        self.end()
     def test_4421_chown_user_socket_accept(self) -> None:
         self.begin()
         self.rm_testdir()
@@ -24661,7 +26540,7 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.end()
     def test_4760_systemctl_py_restart_sec_shortens_interval(self) -> None:
         """ check that we can enable services in a docker container to be run as default-services
-            and RestartSec shortes the InitLoop interval"""
+            and RestartSec shortes the InitLoop interval (without init-loop events)"""
         self.begin()
         self.rm_testdir()
         self.rm_killall()
@@ -24714,7 +26593,91 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         debug_log = os_path(root, expand_path(SYSTEMCTL_DEBUG_LOG))
         os_remove(debug_log)
         text_file(debug_log, "")
-        cmd = "{systemctl} -1"
+        cmd = "{systemctl} -1 -c INIT_LOOP_EVENTS=no"
+        init = background(cmd.format(**locals()))
+        time.sleep(2)
+        #
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        self.assertTrue(greps(top, "sleepA"))
+        self.assertTrue(greps(top, "sleepB"))
+        #
+        logg.info("===============SLEEP")
+        time.sleep(6)
+        #
+        top = _recent(output(_top_list))
+        logg.info("\n>>>\n%s", top)
+        logg.info("==============>>")
+        #
+        log = lines(open(debug_log))
+        logg.info("systemctl.debug.log>\n\t%s", "\n\t".join(log[-20:]))
+        #
+        self.assertTrue(greps(log, ".zzb.service. set InitLoopSleep from 5s to 2 .caused by RestartSec=2.000s"))
+        self.assertFalse(greps(log, "zza.service.*set InitLoopSleep"))
+        #
+        logg.info("kill daemon at %s", init.pid)
+        self.assertTrue(self.kill(init.pid))
+        #
+        self.rm_killall()
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4770_systemctl_py_restart_sec_shortens_interval(self) -> None:
+        """ check that we can enable services in a docker container to be run as default-services
+            and RestartSec shortes the InitLoop interval (without init-loop events)"""
+        self.begin()
+        self.rm_testdir()
+        self.rm_killall()
+        testname = self.testname()
+        testdir = self.testdir()
+        user = self.user()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        logfile = os_path(root, "/var/log/"+testname+".log")
+        testsleepA = self.testname("sleepA")
+        testsleepB = self.testname("sleepB")
+        bindir = os_path(root, "/usr/bin")
+        text_file(os_path(testdir, "zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleepA} 2
+            Restart=on-failure
+            RestartSec=2
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzb.service"),"""
+            [Unit]
+            Description=Testing B
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleepB} 6
+            Restart=on-failure
+            RestartSec=0
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        #
+        copy_tool(_bin_sleep, os_path(bindir, testsleepA))
+        copy_tool(_bin_sleep, os_path(bindir, testsleepB))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        copy_file(os_path(testdir, "zzb.service"), os_path(root, "/etc/systemd/system/zzb.service"))
+        cmd = "{systemctl} enable zza.service"
+        sh____(cmd.format(**locals()))
+        cmd = "{systemctl} enable zzb.service"
+        sh____(cmd.format(**locals()))
+        cmd = "{systemctl} default-services -v"
+        sh____(cmd.format(**locals()))
+        # sh____(cmd.format(**locals()))
+        out2 = output(cmd.format(**locals()))
+        logg.info("\n>\n%s", out2)
+        #
+        debug_log = os_path(root, expand_path(SYSTEMCTL_DEBUG_LOG))
+        os_remove(debug_log)
+        text_file(debug_log, "")
+        cmd = "{systemctl} -1 -c INIT_LOOP_EVENTS=no"
         init = background(cmd.format(**locals()))
         time.sleep(2)
         #
@@ -24733,8 +26696,8 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         log = lines(open(debug_log))
         logg.info("systemctl.debug.log>\n\t%s", "\n\t".join(log[-20:]))
         #
-        self.assertTrue(greps(log, ".zzb.service. set InitLoopSleep from 5s to 2 .caused by RestartSec=2.000s"))
-        self.assertFalse(greps(log, "zza.service.*set InitLoopSleep"))
+        self.assertTrue(greps(log, ".zza.service. set InitLoopSleep from 5s to 2"))
+        self.assertTrue(greps(log, ".zzb.service. set InitLoopSleep from 2s to 1 .caused by RestartSec=0!"))
         #
         logg.info("kill daemon at %s", init.pid)
         self.assertTrue(self.kill(init.pid))
@@ -24743,9 +26706,9 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.rm_testdir()
         self.coverage()
         self.end()
-    def test_4770_systemctl_py_restart_sec_shortens_interval(self) -> None:
+    def test_4780_systemctl_py_restart_sec_without_init_loop_sleep(self) -> None:
         """ check that we can enable services in a docker container to be run as default-services
-            and RestartSec shortes the InitLoop interval"""
+            and the event-driven InitLoop restarts them on RestartSec without a shorter interval"""
         self.begin()
         self.rm_testdir()
         self.rm_killall()
@@ -24754,9 +26717,7 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         user = self.user()
         root = self.root(testdir)
         systemctl = cover() + _systemctl_py + " --root=" + root
-        logfile = os_path(root, "/var/log/"+testname+".log")
         testsleepA = self.testname("sleepA")
-        testsleepB = self.testname("sleepB")
         bindir = os_path(root, "/usr/bin")
         text_file(os_path(testdir, "zza.service"),"""
             [Unit]
@@ -24765,60 +26726,84 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
             Type=simple
             ExecStart={bindir}/{testsleepA} 2
             Restart=on-failure
-            RestartSec=2
+            RestartSec=200ms
             [Install]
             WantedBy=multi-user.target
             """.format(**locals()))
-        text_file(os_path(testdir, "zzb.service"),"""
+        #
+        copy_tool(_bin_sleep, os_path(bindir, testsleepA))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        cmd = "{systemctl} enable zza.service"
+        sh____(cmd.format(**locals()))
+        #
+        debug_log = os_path(root, expand_path(SYSTEMCTL_DEBUG_LOG))
+        os_remove(debug_log)
+        text_file(debug_log, "")
+        cmd = "{systemctl} -1"
+        init = background(cmd.format(**locals()))
+        time.sleep(4) # sleepA fails after 2s, the InitLoopSleep is 5s
+        #
+        log = lines(open(debug_log))
+        logg.info("systemctl.debug.log>\n\t%s", "\n\t".join(log[-20:]))
+        self.assertTrue(greps(log, ".zza.service. --- restarting failed unit"))
+        self.assertFalse(greps(log, "set InitLoopSleep"))
+        #
+        logg.info("kill daemon at %s", init.pid)
+        self.assertTrue(self.kill(init.pid))
+        #
+        self.rm_killall()
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4790_systemctl_py_restart_steps_backoff(self) -> None:
+        """ check that the event-driven InitLoop waits longer for each restart in a row
+            (RestartSteps up to RestartMaxDelaySec) """
+        self.begin()
+        self.rm_testdir()
+        self.rm_killall()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        testsleepA = self.testname("sleepA")
+        bindir = os_path(root, "/usr/bin")
+        text_file(os_path(testdir, "zza.service"),"""
             [Unit]
-            Description=Testing B
+            Description=Testing A
             [Service]
             Type=simple
-            ExecStart={bindir}/{testsleepB} 6
+            ExecStart={bindir}/{testsleepA} 1
             Restart=on-failure
-            RestartSec=0
+            RestartSec=1
+            RestartSteps=3
+            RestartMaxDelaySec=8
+            StartLimitBurst=20
             [Install]
             WantedBy=multi-user.target
             """.format(**locals()))
         #
         copy_tool(_bin_sleep, os_path(bindir, testsleepA))
-        copy_tool(_bin_sleep, os_path(bindir, testsleepB))
         copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
-        copy_file(os_path(testdir, "zzb.service"), os_path(root, "/etc/systemd/system/zzb.service"))
         cmd = "{systemctl} enable zza.service"
         sh____(cmd.format(**locals()))
-        cmd = "{systemctl} enable zzb.service"
-        sh____(cmd.format(**locals()))
-        cmd = "{systemctl} default-services -v"
-        sh____(cmd.format(**locals()))
-        # sh____(cmd.format(**locals()))
-        out2 = output(cmd.format(**locals()))
-        logg.info("\n>\n%s", out2)
+        cmd = "{systemctl} show zza.service -p RestartSteps"
+        self.assertEqual(lines(output(cmd.format(**locals()))), ["RestartSteps=3"])
+        cmd = "{systemctl} show zza.service -p RestartMaxDelaySec"
+        self.assertEqual(lines(output(cmd.format(**locals()))), ["RestartMaxDelaySec=8s"])
         #
         debug_log = os_path(root, expand_path(SYSTEMCTL_DEBUG_LOG))
         os_remove(debug_log)
         text_file(debug_log, "")
         cmd = "{systemctl} -1"
         init = background(cmd.format(**locals()))
-        time.sleep(2)
-        #
-        top = _recent(output(_top_list))
-        logg.info("\n>>>\n%s", top)
-        self.assertTrue(greps(top, "sleepA"))
-        self.assertTrue(greps(top, "sleepB"))
-        #
-        logg.info("===============SLEEP")
-        time.sleep(6)
-        #
-        top = _recent(output(_top_list))
-        logg.info("\n>>>\n%s", top)
-        logg.info("==============>>")
+        time.sleep(12) # fails after 1s and restarts after 1s, 2s, 4s
         #
         log = lines(open(debug_log))
-        logg.info("systemctl.debug.log>\n\t%s", "\n\t".join(log[-20:]))
-        #
-        self.assertTrue(greps(log, ".zza.service. set InitLoopSleep from 5s to 2"))
-        self.assertTrue(greps(log, ".zzb.service. set InitLoopSleep from 2s to 1 .caused by RestartSec=0!"))
+        logg.info("systemctl.debug.log>\n\t%s", "\n\t".join(greps(log, "restart scheduled")))
+        self.assertTrue(greps(log, "zza.service. restart scheduled in [+]1.000s .0 restarts in a row"))
+        self.assertTrue(greps(log, "zza.service. restart scheduled in [+]2.000s .1 restarts in a row"))
+        self.assertTrue(greps(log, "zza.service. restart scheduled in [+]4.000s .2 restarts in a row"))
+        self.assertFalse(greps(log, "set InitLoopSleep"))
         #
         logg.info("kill daemon at %s", init.pid)
         self.assertTrue(self.kill(init.pid))
@@ -25174,6 +27159,281 @@ class DockerSystemctlReplacementTest(unittest.TestCase):
         self.rm_testdir()
         self.coverage()
         self.end()
+    def test_4886_set_exec_limits_and_scheduling(self) -> None:
+        """ check that LimitNOFILE= Nice= CPUAffinity= OOMScoreAdjust= are set for the service """
+        self.begin()
+        self.rm_testdir()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        logfile = os_path(root, "/var/log/"+testname+".log")
+        text_file(os_path(testdir, "zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=oneshot
+            ExecStart=/bin/sh -c 'echo nofile $(ulimit -Sn) $(ulimit -Hn) > {logfile}'
+            ExecStart=/bin/sh -c 'echo nice $(ps -o ni= -p $$) >> {logfile}'
+            ExecStart=/bin/sh -c 'grep Cpus_allowed_list /proc/self/status >> {logfile}'
+            ExecStart=/bin/sh -c 'echo oom $(cat /proc/self/oom_score_adj) >> {logfile}'
+            LimitNOFILE=1000:2000
+            Nice=3
+            CPUAffinity=0
+            IOSchedulingClass=idle
+            OOMScoreAdjust=100
+            [Install]
+            WantedBy=multi-user.target
+            """.format(**locals()))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        os.makedirs(os_path(root, "/var/log"))
+        #
+        cmd = "{systemctl} show zza.service"
+        out, err, rc = output3(cmd.format(**locals()))
+        logg.info("\n>>>(%s)\n%s\n%s", rc, i2(err), out)
+        self.assertEqual(rc, 0)
+        self.assertTrue(greps(out, "^LimitNOFILE=2000"))
+        self.assertTrue(greps(out, "^LimitNOFILESoft=1000"))
+        self.assertTrue(greps(out, "^Nice=3"))
+        self.assertTrue(greps(out, "^CPUAffinity=0"))
+        self.assertTrue(greps(out, "^IOSchedulingClass=idle"))
+        self.assertTrue(greps(out, "^OOMScoreAdjust=100"))
+        #
+        cmd = "{systemctl} start zza.service -vvvv"
+        out, err, rc = output3(cmd.format(**locals()))
+        logg.info("\n>>>(%s)\n%s\n%s", rc, i2(err), out)
+        self.assertEqual(rc, 0)
+        log = lines(open(logfile))
+        logg.info("LOG %s\n%s", logfile, i2("\n".join(log)))
+        self.assertTrue(greps(log, "nofile 1000 2000"))
+        self.assertTrue(greps(log, "nice 3"))
+        self.assertTrue(greps(log, "Cpus_allowed_list:\\s*0$"))
+        self.assertTrue(greps(log, "oom 100"))
+        #
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4887_posix_spawn_for_plain_exec_commands(self) -> None:
+        """ check that the exec commands are spawned without a python child when possible """
+        if not hasattr(os, "posix_spawn"):
+            self.skipTest("no os.posix_spawn")
+        self.begin()
+        self.rm_testdir()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + realpath(_systemctl_py) + " --root=" + root
+        logfile = os_path(root, "/var/log/"+testname+".log")
+        text_file(os_path(testdir, "zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=oneshot
+            ExecStartPre=/bin/sh -c 'echo pre $$ >> {logfile}'
+            ExecStart=/bin/sh -c 'echo start $$ >> {logfile}'
+            ExecStart=/bin/sh -c 'echo err $$ >&2'
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzb.service"),"""
+            [Unit]
+            Description=Testing B
+            [Service]
+            Type=oneshot
+            ExecStart=/bin/sh -c 'echo start $$ >> {logfile}'
+            Nice=1
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzc.service"),"""
+            [Unit]
+            Description=Testing C
+            [Service]
+            Type=oneshot
+            ExecStart=-{root}/usr/bin/nonexistent
+            StandardError=file:/dev/null/zzc/err.log
+            """.format(**locals()))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        copy_file(os_path(testdir, "zzb.service"), os_path(root, "/etc/systemd/system/zzb.service"))
+        copy_file(os_path(testdir, "zzc.service"), os_path(root, "/etc/systemd/system/zzc.service"))
+        os.makedirs(os_path(root, "/var/log"))
+        #
+        cmd = "cd {root} && {systemctl} start zza.service -vvvv"
+        out, err, rc = output3(cmd.format(**locals()))
+        logg.info("\n>>>(%s)\n%s\n%s", rc, i2(err), out)
+        self.assertEqual(rc, 0)
+        self.assertEqual(len(greps(err, "posix_spawn PID")), 3)
+        log = lines(open(logfile))
+        self.assertTrue(greps(log, "^pre "))
+        self.assertTrue(greps(log, "^start "))
+        journal = lines(open(os_path(root, "/var/log/journal/zza.service.log")))
+        self.assertTrue(greps(journal, "^err "))
+        #
+        cmd = "cd {root} && {systemctl} start zzb.service -vvvv"
+        out, err, rc = output3(cmd.format(**locals()))
+        logg.info("\n>>>(%s)\n%s\n%s", rc, i2(err), out)
+        self.assertEqual(rc, 0)
+        self.assertFalse(greps(err, "posix_spawn PID")) # Nice= needs a python child
+        log = lines(open(logfile))
+        self.assertEqual(len(greps(log, "^start ")), 2)
+        #
+        cmd = "cd {root} && {systemctl} start zzc.service -vvvv"
+        out, err, rc = output3(cmd.format(**locals()))
+        logg.info("\n>>>(%s)\n%s\n%s", rc, i2(err), out)
+        journal = lines(open(os_path(root, "/var/log/journal/zzc.service.log")))
+        logg.info("zzc.service.log>>\n%s", "\n".join(journal))
+        self.assertEqual(len(greps(journal, "^ERROR:.*err.log")), 1) # not again from the fork
+        #
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4888_list_units_and_status_of_many_units(self) -> None:
+        """ check that list-units and status get the same states when checking many units at once """
+        self.begin()
+        self.rm_testdir()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        testsleep = self.testname("sleep")
+        bindir = os_path(root, "/usr/bin")
+        text_file(os_path(testdir, "zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleep} 40
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzb.service"),"""
+            [Unit]
+            Description=Testing B
+            [Service]
+            Type=oneshot
+            ExecStart=/bin/false
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzc.service"),"""
+            [Unit]
+            Description=Testing C
+            [Service]
+            Type=simple
+            ExecStart={bindir}/{testsleep} 50
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleep))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        copy_file(os_path(testdir, "zzb.service"), os_path(root, "/etc/systemd/system/zzb.service"))
+        copy_file(os_path(testdir, "zzc.service"), os_path(root, "/etc/systemd/system/zzc.service"))
+        #
+        cmd = "{systemctl} start zza.service"
+        sh____(cmd.format(**locals()))
+        cmd = "{systemctl} start zzb.service"
+        sx____(cmd.format(**locals()))
+        cmd = "{systemctl} --no-legend list-units"
+        out, err, rc = output3(cmd.format(**locals()))
+        logg.info("\n>>>(%s)\n%s\n%s", rc, i2(err), out)
+        self.assertEqual(rc, 0)
+        self.assertTrue(greps(out, r"zza.service\s+loaded active running\s+Testing A"))
+        self.assertTrue(greps(out, r"zzb.service\s+loaded failed dead\s+Testing B"))
+        self.assertTrue(greps(out, r"zzc.service\s+loaded inactive dead\s+Testing C"))
+        cmd = "{systemctl} status zza.service zzb.service zzc.service"
+        out, err, rc = output3(cmd.format(**locals()))
+        logg.info("\n>>>(%s)\n%s\n%s", rc, i2(err), out)
+        self.assertEqual(rc, 3)
+        self.assertTrue(greps(out, r"Active: active \(running\)"))
+        self.assertTrue(greps(out, r"Active: failed \(dead\)"))
+        self.assertTrue(greps(out, r"Active: inactive \(dead\)"))
+        #
+        self.killall("*" + testsleep + " 40*", 10)
+        self.assertFalse(greps(_recent(output(_top_list)), testsleep))
+        cmd = "{systemctl} --no-legend list-units"
+        out, err, rc = output3(cmd.format(**locals()))
+        logg.info("\n>>>(%s)\n%s\n%s", rc, i2(err), out)
+        self.assertEqual(rc, 0)
+        self.assertFalse(greps(out, r"zza.service\s+loaded active"))
+        self.assertTrue(greps(out, r"zzb.service\s+loaded failed dead\s+Testing B"))
+        self.assertTrue(greps(out, r"zzc.service\s+loaded inactive dead\s+Testing C"))
+        #
+        self.rm_testdir()
+        self.coverage()
+        self.end()
+    def test_4889_timings_and_analyze_blame(self) -> None:
+        """ check that --timings records the start phases for analyze blame and critical-chain """
+        self.begin()
+        self.rm_testdir()
+        testname = self.testname()
+        testdir = self.testdir()
+        root = self.root(testdir)
+        systemctl = cover() + _systemctl_py + " --root=" + root
+        testsleep = self.testname("sleep")
+        bindir = os_path(root, "/usr/bin")
+        text_file(os_path(testdir, "zza.service"),"""
+            [Unit]
+            Description=Testing A
+            [Service]
+            Type=simple
+            ExecStartPre=/bin/sleep 1
+            ExecStart={bindir}/{testsleep} 40
+            """.format(**locals()))
+        text_file(os_path(testdir, "zzb.service"),"""
+            [Unit]
+            Description=Testing B
+            After=zza.service
+            [Service]
+            Type=oneshot
+            ExecStart=/bin/sleep 2
+            """.format(**locals()))
+        copy_tool(_bin_sleep, os_path(bindir, testsleep))
+        copy_file(os_path(testdir, "zza.service"), os_path(root, "/etc/systemd/system/zza.service"))
+        copy_file(os_path(testdir, "zzb.service"), os_path(root, "/etc/systemd/system/zzb.service"))
+        #
+        cmd = "{systemctl} start zza.service"
+        sh____(cmd.format(**locals()))
+        status = reads(os_path(root, "/run/zza.service.status"))
+        self.assertNotIn("Timing", status)
+        cmd = "{systemctl} stop zza.service"
+        sh____(cmd.format(**locals()))
+        cmd = "{systemctl} analyze critical-chain"
+        out, err, rc = output3(cmd.format(**locals()))
+        logg.info("\n>>>(%s)\n%s\n%s", rc, i2(err), out)
+        self.assertEqual(rc, 1)
+        self.assertTrue(greps(err, "use --timings"))
+        #
+        cmd = "{systemctl} start zza.service zzb.service --timings"
+        sh____(cmd.format(**locals()))
+        status = lines(reads(os_path(root, "/run/zza.service.status")))
+        logg.info("zza status\n%s", i2("\n".join(status)))
+        for phase in [ "StartBegin", "StartLocked", "StartPre", "StartExec", "StartReady", "StartPost", "StartDone" ]:
+            self.assertTrue(greps(status, "^Timing%s=\\d+$" % phase))
+        self.assertTrue(greps(status, "^TimingStartWait=sleep"))
+        timing = dict(line.split("=", 1) for line in status if line.startswith("Timing"))
+        self.assertLessEqual(int(timing["TimingStartBegin"]), int(timing["TimingStartLocked"]))
+        self.assertLessEqual(int(timing["TimingStartLocked"]), int(timing["TimingStartPre"]))
+        status = lines(reads(os_path(root, "/run/zzb.service.status")))
+        self.assertTrue(greps(status, "^TimingStartWait=exit"))
+        cmd = "{systemctl} analyze blame"
+        out, err, rc = output3(cmd.format(**locals()))
+        logg.info("\n>>>(%s)\n%s\n%s", rc, i2(err), out)
+        self.assertEqual(rc, 0)
+        self.assertEqual(len(lines(out)), 2)
+        self.assertTrue(greps(lines(out)[0], r"^\s+2.\d+s zzb.service \(.*exit 2.\d+s\)"))
+        self.assertTrue(greps(lines(out)[1], r"^\s+1.\d+s zza.service \(.*pre 1.\d+s, sleep"))
+        cmd = "{systemctl} analyze critical-chain"
+        out, err, rc = output3(cmd.format(**locals()))
+        logg.info("\n>>>(%s)\n%s\n%s", rc, i2(err), out)
+        self.assertEqual(rc, 0)
+        self.assertTrue(greps(out, r"^zzb.service @\d.\d+s \+2.\d+s$"))
+        self.assertTrue(greps(out, r"^[|] zza.service @1.\d+s \+1.\d+s$"))
+        #
+        cmd = "{systemctl} stop zza.service --timings"
+        sh____(cmd.format(**locals()))
+        cmd = "{systemctl} is-active zza.service"
+        out, err, rc = output3(cmd.format(**locals()))
+        self.assertEqual(out.strip(), "inactive")
+        cmd = "{systemctl} analyze blame zza.service"
+        out, err, rc = output3(cmd.format(**locals()))
+        logg.info("\n>>>(%s)\n%s\n%s", rc, i2(err), out)
+        self.assertEqual(rc, 0)
+        self.assertEqual(len(lines(out)), 1)
+        self.assertTrue(greps(out, r"zza.service \(.*pre 1.\d+s, .*stop \d+ms\)"))
+        #
+        self.rm_testdir()
+        self.coverage()
+        self.end()
     def test_4900_unreadable_files_can_be_handled(self) -> None:
         """ a file may exist but it is unreadable"""
         self.begin()
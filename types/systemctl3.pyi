@@ -5,7 +5,7 @@
 import collections
 import logging
 from collections import namedtuple
-from typing import Callable, Dict, Iterable, List, NoReturn, Optional, TextIO, Tuple, Type, Union
+from typing import Any, Callable, Dict, Set, Iterable, List, NoReturn, Optional, TextIO, Tuple, Type, Union
 from typing import NamedTuple, Match, TextIO, BinaryIO, Sequence, overload, Generator
 from types import TracebackType
 
@@ -28,6 +28,8 @@ NOT_OK: int
 NOT_ACTIVE: int
 NOT_FOUND: int
 _force: bool
+_log_since: Optional[str]
+_log_until: Optional[str]
 _full: bool
 _now: bool
 _no_legend: bool
@@ -35,6 +37,7 @@ _no_ask_password: bool
 _preset_mode: str
 _quiet: bool
 _root: str
+_timings: bool
 _unit_type: Optional[str]
 _unit_state: Optional[str]
 _unit_property: Optional[str]
@@ -71,7 +74,17 @@ DefaultMaximumTimeout: int
 DefaultRestartSec: float
 DefaultStartLimitIntervalSec: int
 DefaultStartLimitBurst: int
+DefaultMaxConnections: int
 InitLoopSleep: int
+ReapedStatusSec: int
+LogForwardPollSec: float
+JournalLogMaxSize: int
+JournalIndexSec: int
+ControlTimeoutSec: int
+MaxParallelJobs: int
+InitStopParallelJobs: int
+MetricsIntervalSec: float
+ChownParallelJobs: int
 MaxLockWait: int
 DefaultPath: str
 ResetLocale: List[str]
@@ -79,6 +92,7 @@ ExitWhenNoMoreServices: bool
 ExitWhenNoMoreProcs: bool
 DefaultUnit: str
 DefaultTarget: str
+EXEC_POSIX_SPAWN: bool
 REMOVE_LOCK_FILE: bool
 BOOT_PID_MIN: int
 BOOT_PID_MAX: int
@@ -86,8 +100,29 @@ PROC_MAX_DEPTH: int
 EXPAND_VARS_MAXDEPTH: int
 EXPAND_KEEP_VARS: bool
 RESTART_FAILED_UNITS: bool
+INIT_LOOP_EVENTS: bool
+UNIT_FILE_CACHE: bool
+INOTIFY: bool
+LOG_FORWARDER: bool
+LOG_READER: bool
+ReadOnlyCommands: List[str]
+ControlCommands: List[str]
+JOURNAL_PIPES: bool
+CONTROL_SOCKET: bool
+CGROUP_TRACKING: bool
+METRICS_TEXTFILE: bool
+_unit_file_cache: str
+_boottime_cache: str
 _pid_file_folder: str
 _journal_log_folder: str
+_journal_pipe_folder: str
+_control_socket_file: str
+_cgroup_base_file: str
+_metrics_textfile: str
+_metrics_start_buckets: List[float]
+_proc_self_cgroup: str
+_proc_self_oom_score_adj: str
+_cgroup_folder: str
 SYSTEMCTL_DEBUG_LOG: str
 SYSTEMCTL_EXTRA_LOG: str
 _default_targets: List[str]
@@ -106,6 +141,7 @@ def shell_cmd(cmd: List[str]) -> str: ...
 def to_int(value: str, default: int=...) -> int: ...
 def to_intN(value: Optional[str], default: Optional[int]=...) -> Optional[int]: ...
 def to_list(value: Union[str, List[str], Tuple[str], Tuple[str, ...], None]) -> List[str]: ...
+def thread_map(func: Callable[[Any], Any], items: List[Any], jobs: int) -> List[Any]: ...
 def unit_of(module: str) -> str: ...
 def int_mode(value: str) -> Optional[int]: ...
 def o22(part: str) -> str: ...
@@ -116,6 +152,7 @@ def unit_name_unescape(text: str) -> str: ...
 def is_good_root(root: Optional[str]) -> bool: ...
 def os_path(root: Optional[str], path: str) -> str: ...
 def path_replace_extension(path: str, old: str, new: str) -> str: ...
+def json_str_hook(data: Dict[str, object]) -> Dict[str, object]: ...
 def get_PAGER() -> List[str]: ...
 def os_getlogin() -> str: ...
 def get_runtime_dir() -> str: ...
@@ -141,10 +178,61 @@ def shutil_chown(path: str, user: Optional[str], group: Optional[str]) -> None:
 def shutil_fchown(fileno: int, user: Optional[str], group: Optional[str]) -> None: ...
 def shutil_setuid(user: Optional[str]=..., group: Optional[str]=..., xgroups: Optional[List[str]]=...) -> Dict[str, str]: ...
 def shutil_truncate(filename: str) -> None: ...
+def path_temp_name(filename: str) -> str: ...
 def pid_exists(pid: int) -> bool: ...
 def _pid_exists(pid: int) -> bool: ...
 def pid_zombie(pid: int) -> bool: ...
 def _pid_zombie(pid: int) -> bool: ...
+proc_result = NamedTuple("ProcEntry", [("pid", int), ("ppid", int), ("state", str), ("starttime", int)])
+
+def get_errno() -> int: ...
+
+IN_MODIFY: int
+IN_CLOSE_WRITE: int
+IN_MOVED_TO: int
+IN_CREATE: int
+
+class InotifyWatch:
+    libc: Any
+    fd: int
+    def __init__(self, libc: Any, fd: int) -> None: ...
+    def add(self, path: str, mask: int = ...) -> bool: ...
+    def wait(self, timeout: float) -> bool: ...
+    def drain(self) -> None: ...
+    def close(self) -> None: ...
+
+def inotify_watch() -> Optional[InotifyWatch]: ...
+IOPRIO_CLASSES: Dict[str, int]
+IOPRIO_SYSCALLS: Dict[str, int]
+def ioprio_set(ioclass: int, level: int) -> bool: ...
+
+def pid_open(pid: Optional[int]) -> Optional[int]: ...
+
+class ProcTable:
+    _pids: List[int] = ...
+    _entries: Optional[Dict[int, proc_result]] = ...
+    _pidset: Set[int] = ...
+    _children: Optional[Dict[int, List[int]]] = ...
+    _cmdline: Dict[int, List[str]] = ...
+    def __init__(self) -> None: ...
+    def pids(self) -> List[int]: ...
+    def entries(self) -> Dict[int, proc_result]: ...
+    def read_entry(self, pid: int) -> Optional[proc_result]: ...
+    def entry(self, pid: int) -> Optional[proc_result]: ...
+    def exists(self, pid: int) -> bool: ...
+    def zombie(self, pid: int) -> bool: ...
+    def alive(self, pid: int) -> bool: ...
+    def children(self, pid: int) -> List[int]: ...
+    def descendants(self, pid: int) -> List[int]: ...
+    def cmdline(self, pid: int) -> List[str]: ...
+
+_env_file_single_quoted: Any
+_env_file_double_quoted: Any
+_env_file_unquoted: Any
+_env_part_assignment: Any
+_expand_env_var: Any
+_expand_env_braced: Any
+_expand_special_var: Any
 def checkstatus(cmd: str) -> Tuple[bool, str]: ...
 def ignore_signals_and_raise_keyboard_interrupt(signame: str) -> None: ...
 
@@ -178,12 +266,18 @@ class SystemctlConfigParser(SystemctlConfData):
 UnitConfParser = SystemctlConfigParser
 
 class SystemctlSocket:
+    conf: SystemctlConf
+    sock: socket.socket
+    skip: bool
+    accepted: int
+    connections: Dict[str, Tuple[str, SystemctlConf]]
     def __init__(self, conf: SystemctlConf, sock: socket.socket , skip: bool = False) -> None: ...
     def fileno(self) -> int: ...
     def listen(self, backlog: Optional[int] = None) -> None: ...
     def name(self) -> str: ...
     def addr(self) -> str: ...
     def close(self) -> None: ...
+def socket_connection_names(conn: socket.socket, addr: Any, nr: int) -> Tuple[str, str]: ...
 class SystemctlConf:
     data: SystemctlConfData
     env: Dict[str, str]
@@ -214,6 +308,8 @@ class PresetFile:
     def read(self, filename: str) -> PresetFile: ...
     def get_preset(self, unit: str) -> Optional[str]: ...
 
+class WaitLockTimeout(Exception): ...
+def waitlock_alarm(signum: int, frame: Any) -> None: ...
 class waitlock:
     conf: SystemctlConf = ...
     opened: int = ...
@@ -221,27 +317,112 @@ class waitlock:
     def __init__(self, conf: SystemctlConf) -> None: ...
     def lockfile(self) -> str: ...
     def __enter__(self) -> bool: ...
+    def flock(self, timeout: float) -> None: ...
+    def __exit__(self, type: Optional[Type[BaseException]], value: Optional[BaseException], traceback: Optional[TracebackType]) -> None: ...
+class batchstates:
+    systemctl: Systemctl = ...
+    saved: Tuple[Optional[ProcTable], Optional[Dict[str, Set[str]]]] = ...
+    def __init__(self, systemctl: Systemctl) -> None: ...
+    def __enter__(self) -> batchstates: ...
     def __exit__(self, type: Optional[Type[BaseException]], value: Optional[BaseException], traceback: Optional[TracebackType]) -> None: ...
 
 def must_have_failed(waitpid: waitpid_result, cmd: List[str]) -> waitpid_result: ...
+_reaped_status: Dict[int, Tuple[int, float]]
+_reaped_lock: threading.Lock
+def reap_zombie() -> Tuple[int, int]: ...
+def reaped_waitpid(pid: int, options: int) -> Tuple[int, int]: ...
 def subprocess_waitpid(pid: int) -> waitpid_result: ...
 def subprocess_testpid(pid: int) -> waitpid_result: ...
 def parse_unit(fullname: str) -> parse_result: ...
+def size_to_bytes(text: str) -> Optional[int]: ...
 def time_to_seconds(text: str, maximum: float) -> float: ...
 def seconds_to_time(seconds: float) -> str: ...
+def monotonic_usec() -> int: ...
+def usec_to_time(usec: int) -> str: ...
+def timing_span(timings: Dict[str, str], begin: str, end: str) -> Optional[int]: ...
+_journal_time_span: Any
+_journal_time_units: Dict[str, int]
+_journal_time_formats: List[str]
+def journal_time(text: str, now: Optional[float] = None) -> Optional[float]: ...
+def journal_index_range(index_file: str, size: int, since: Optional[float] = None, until: Optional[float] = None) -> Tuple[int, int]: ...
+def journal_tail_offset(fd: int, start: int, end: int, lines: int) -> int: ...
+def journal_copy(fd: int, start: int, end: int) -> bool: ...
 def getBefore(conf: SystemctlConf) -> List[str]:
     result : List[str]
 def getAfter(conf: SystemctlConf) -> List[str]:
     result : List[str]
 def compareAfter(confA: SystemctlConf, confB: SystemctlConf) -> int: ...
-def conf_sortedAfter(conflist: Iterable[SystemctlConf], cmp: Callable[[SystemctlConf, SystemctlConf], int] = ...) -> List[SystemctlConf]:
-    class SortTuple:
-       def __init__(self, rank : int, conf: SystemctlConf) -> None: ...
+class SortedAfterGraph:
+    confs: List[SystemctlConf]
+    names: List[str]
+    index: Dict[str, List[int]]
+    before: List[Set[int]]
+    after: List[Set[int]]
+    def __init__(self, conflist: Iterable[SystemctlConf]) -> None: ...
+    def edge(self, first: int, then: int) -> None: ...
+    def requires(self, name: str) -> List[str]: ...
+    def ranks(self) -> List[int]: ...
+    def sorted(self) -> List[SystemctlConf]: ...
+
+def conf_sortedAfter(conflist: Iterable[SystemctlConf]) -> List[SystemctlConf]: ...
+
+class SystemctlLogForwarder:
+    systemctl: Systemctl
+    units: List[str]
+    stopping: Tuple[int, int]
+    def __init__(self, systemctl: Systemctl, units: List[str]) -> None: ...
+    def stop(self) -> None: ...
+    def run(self) -> None: ...
 
 class SystemctlListenThread:
+    systemctl: Systemctl
+    stopping: Tuple[int, int]
+    def __init__(self, systemctl: Systemctl) -> None: ...
+    def stop(self) -> None: ...
+    def readable(self, fileno: int) -> bool: ...
+    def run(self) -> None: ...
+
+class ControlOutput:
+    texts: List[str]
+    def __init__(self) -> None: ...
+    def write(self, text: str) -> None: ...
+    def flush(self) -> None: ...
+    def getvalue(self) -> str: ...
+
+class ControlStdout:
+    stdout: TextIO
+    pid: int
+    outputs: Dict[int, ControlOutput]
+    def __init__(self, stdout: TextIO) -> None: ...
+    def current(self) -> Union[TextIO, ControlOutput]: ...
+    def write(self, text: str) -> None: ...
+    def flush(self) -> None: ...
+    def __getattr__(self, name: str) -> Any: ...
+
+class ControlLogFilter(logging.Filter):
+    enabled: Callable[[int], bool]
+    pid: int
+    formatter: logging.Formatter
+    errors: Dict[int, ControlOutput]
+    def __init__(self, logger: logging.Logger) -> None: ...
+    def requested(self, ident: Optional[int]) -> Optional[ControlOutput]: ...
+    def isEnabledFor(self, level: int) -> bool: ...
+    def filter(self, record: logging.LogRecord) -> bool: ...
+
+class SystemctlControlThread:
+    systemctl: Systemctl
+    stopping: Tuple[int, int]
+    sock: Optional[socket.socket]
+    socketfile: str
+    stdout: ControlStdout
+    logfilter: ControlLogFilter
     def __init__(self, systemctl: Systemctl) -> None: ...
+    def listen(self) -> bool: ...
     def stop(self) -> None: ...
     def run(self) -> None: ...
+    def accepting(self) -> None: ...
+    def serving(self, conn: socket.socket) -> None: ...
+    def serve(self, conn: socket.socket) -> None: ...
 
 class Systemctl:
     error: int = ...
@@ -256,6 +437,7 @@ class Systemctl:
     _quiet: bool = ...
     _root: str = ...
     _show_all: bool = ...
+    _timings: bool = ...
     _unit_property: Optional[str] = ...
     _unit_state: Optional[str] = ...
     _unit_type: Optional[str] = ...
@@ -266,6 +448,10 @@ class Systemctl:
     _loaded_file_sysd: Dict[str, SystemctlConf] = ...
     _file_for_unit_sysv: Optional[Dict[str, str]] = ...
     _file_for_unit_sysd: Optional[Dict[str, str]] = ...
+    _unit_cache: Optional[Dict[str, object]] = ...
+    _unit_cache_sysv_folders: List[List[object]] = ...
+    _unit_cache_sysd_folders: List[List[object]] = ...
+    _unit_cache_sysd_confs: Dict[str, Dict[str, object]] = ...
     _preset_file_list: Optional[Dict[str, PresetFile]] = ...
     _default_target: str = ...
     _sysinit_target: Optional[SystemctlConf] = ...
@@ -275,13 +461,35 @@ class Systemctl:
     _user_getlogin: str = ...
     _log_file: Dict[str, int] = ...
     _log_hold: Dict[str, bytes] = ...
+    _log_tee: Dict[str, int] = ...
+    _log_index: Dict[str, Tuple[int, float, int]] = ...
+    _accepted: Optional[int] = ...
+    _cgroup_base: Optional[str] = ...
+    _read_only: bool = ...
+    _log_forwarder: Optional[SystemctlLogForwarder] = ...
     _boottime: Optional[float] = ...
     _SYSTEMD_UNIT_PATH: Optional[str] = ...
     _SYSTEMD_SYSVINIT_PATH: Optional[str] = ...
     _SYSTEMD_PRESET_PATH: Optional[str] = ...
     _restarted_unit: Dict[str, List[float]] = ...
     _restart_failed_units: Dict[str, float] = ...
+    _restart_backoff: Dict[str, Tuple[int, float]] = ...
     _sockets: Dict[str, SystemctlSocket] = ...
+    _loop_wakeup: Optional[Tuple[int, int]] = ...
+    _loop_timers: List[Tuple[float, str]] = ...
+    _running_procs: Optional[int] = ...
+    _reaped_zombies: int = ...
+    _restart_counts: Dict[str, int] = ...
+    _start_seconds: Dict[str, List[float]] = ...
+    _loop_ticks: List[float] = ...
+    _metrics_written: float = ...
+    _status_files: Dict[str, Tuple[Optional[Tuple[int, int, float]], Dict[str, str]]] = ...
+    _env_files: Dict[str, Tuple[Tuple[float, int], List[Tuple[str, str]]]] = ...
+    _special_confs: Dict[Optional[Tuple[str, str]], Dict[str, str]] = ...
+    _proc_snapshot: Optional[ProcTable] = ...
+    _status_folders: Optional[Dict[str, Set[str]]] = ...
+    _dependencies: Dict[Tuple[str, Tuple[str, ...]], Dict[str, str]] = ...
+    _dependencies_closure: Dict[Tuple[str, Tuple[str, ...]], Dict[str, List[str]]] = ...
     loop: threading.Lock = threading.Lock()
     def __init__(self) -> None: ...
     def user(self) -> str: ...
@@ -306,6 +514,13 @@ class Systemctl:
     def not_user_conf(self, conf : SystemctlConf) -> bool: ...
     def find_drop_in_files(self, unit : str) -> Dict[str, str]:
         result : Dict[str, str]
+    def unit_cache_file(self) -> str: ...
+    def refresh_unit_files(self) -> bool: ...
+    def unit_cache(self) -> Dict[str, object]: ...
+    def unit_cache_folders(self, folders: Iterable[Optional[str]]) -> List[List[object]]: ...
+    def unit_cache_files(self, filenames: List[str]) -> List[List[object]]: ...
+    def write_unit_cache(self) -> bool: ...
+    def load_sysd_unit_data(self, path: str) -> Tuple[SystemctlConfigParser, Dict[str, str]]: ...
     def load_sysd_template_conf(self, module : Optional[str]) -> Optional[SystemctlConf]: ... # -> conf?
     def load_sysd_unit_conf(self, module : Optional[str]) -> Optional[SystemctlConf]: # -> conf?
         drop_in_files : Dict[str, str]
@@ -352,13 +567,19 @@ class Systemctl:
     def get_StatusFile(self, conf : SystemctlConf, default : Optional[str] = None) -> str: ... # -> text
     def clean_status_from(self, conf : SystemctlConf) -> None: ...
     def write_status_from(self, conf : SystemctlConf, **status : Union[str, int, None]) -> bool: ... # -> bool(written)
+    def status_file_missing(self, status_file: str) -> bool: ...
+    def status_file_stat(self, status_file: str) -> Optional[Tuple[int, int, float]]: ...
     def read_status_from(self, conf : SystemctlConf) -> Dict[str, str]:
         status: Dict[str, str]
     def get_status_from(self, conf : SystemctlConf, name : str, default: Optional[str] = None) -> Optional[str]: ...
     def set_status_from(self, conf : SystemctlConf, name : str, value : Optional[str]) -> None: ...
+    def set_timing_from(self, conf : SystemctlConf, phase : str, usec : Optional[int] = None, wait : Optional[str] = None) -> None: ...
+    def get_timings_from(self, conf : SystemctlConf) -> Dict[str, str]: ...
     def get_boottime(self) -> float: ...
     def get_boottime_from_proc(self) -> float: ...
     def get_boottime_from_old_proc(self) -> float: ...
+    def boottime_cache_file(self) -> str: ...
+    def path_proc_started_cached(self, proc: str) -> float: ...
     def path_proc_started(self, proc: str) -> float: ...
     def get_filetime(self, filename: str) -> float: ...
     def truncate_old(self, filename: str) -> bool: ...
@@ -401,6 +622,7 @@ class Systemctl:
     def make_service_directory(self, path: str, mode: str) -> bool: ...
     def chown_service_directory(self, path: str, user: Optional[str], group: Optional[str]) -> bool: ...
     def do_chown_tree(self, path: str, user: Optional[str], group: Optional[str]) -> bool: ...
+    def do_chown_folder(self, dirpath: str, uid: int, gid: int, user: Optional[str], group: Optional[str]) -> Tuple[List[str], bool]: ...
     def clean_modules(self, *modules: str) -> bool:
         units: List[str]
     def clean_units(self, units: List[str], what: str = "") -> bool: ...
@@ -411,8 +633,12 @@ class Systemctl:
     def log_units(self, units: List[str], lines: Optional[int] = None, follow: bool = False) -> int: ...
     def log_unit(self, unit: str, lines: Optional[int] = None, follow: bool = False) -> int: ...
     def log_unit_from(self, conf: SystemctlConf, lines: Optional[int] = None, follow: bool = False) -> int: ...
+    def read_journal_log(self, conf: SystemctlConf, lines: Optional[int] = None, follow: bool = False) -> int: ...
+    def get_journal_index_from(self, conf: SystemctlConf) -> str: ...
     def get_journal_log_from(self, conf: SystemctlConf) -> str: ... # never None
     def get_journal_log(self, conf: SystemctlConf) -> str: ... # never None
+    def get_journal_pipe_from(self, conf: SystemctlConf) -> str: ...
+    def open_journal_pipe(self, conf: SystemctlConf) -> Optional[TextIO]: ...
     def open_journal_log(self, conf: SystemctlConf) -> TextIO: ...
     def skip_journal_log(self, conf: SystemctlConf) -> bool: ...
     def dup2_journal_log(self, conf: SystemctlConf) -> None: ...
@@ -421,16 +647,22 @@ class Systemctl:
     def get_notify_socket_from(self, conf: SystemctlConf, socketfile: Optional[str] = None, debug: bool = False) -> str: ...
     def notify_socket_from(self, conf: SystemctlConf, socketfile: Optional[str] = None) -> NotifySocket: ...
     def read_notify_socket(self, notify: NotifySocket, timeout: float) -> str: ...
+    def read_notify_datagrams(self, notify: NotifySocket) -> str: ...
     def wait_notify_socket(self, notify: NotifySocket, timeout: float, pid: Optional[int] = None, pid_file: Optional[str] = None) -> Dict[str,str]:
         results: Dict[str, str]
     def start_modules(self, *modules: str) -> bool:
         units: List[str]
     def start_units(self, units: List[str], init: Optional[bool] = None) -> bool: ...
+    def start_jobs_requires(self, units: List[str]) -> Dict[str, List[str]]: ...
+    def stop_jobs_requires(self, units: List[str]) -> Dict[str, List[str]]: ...
+    def parallel_jobs(self, units: List[str], requires: Dict[str, List[str]], job: Callable[[str], bool], maxjobs: Optional[int] = None) -> Dict[str, bool]: ...
     def start_unit(self, unit: str) -> bool: ...
+    def stop_started_units(self, started_units: List[str]) -> bool: ...
     def get_TimeoutStartSec(self, conf: SystemctlConf) -> float: ...
     def get_SocketTimeoutSec(self, conf: SystemctlConf) -> float: ...
     def get_RemainAfterExit(self, conf: SystemctlConf) -> bool: ...
     def start_unit_from(self, conf: SystemctlConf) -> bool: ...
+    def note_start_seconds(self, unit: str, seconds: float) -> None: ...
     def do_start_unit_from(self, conf: SystemctlConf) -> bool: ...
     def do_start_service_from(self, conf: SystemctlConf) -> bool: ...
     def listen_modules(self, *modules: str) -> bool:
@@ -440,6 +672,12 @@ class Systemctl:
     def listen_unit_from(self, conf: SystemctlConf) -> bool: ...
     def do_listen_unit_from(self, conf: SystemctlConf) -> bool: ...
     def do_accept_socket_from(self, conf: SystemctlConf, sock: socket.socket) -> bool: ...
+    def do_accept_connection_from(self, sock: SystemctlSocket) -> Optional[threading.Thread]: ...
+    def serve_connection_from(self, sock: SystemctlSocket, conf: SystemctlConf, conn: socket.socket) -> None: ...
+    def dup2_connection(self, env: Dict[str, str]) -> None: ...
+    def get_MaxConnections(self, conf: SystemctlConf) -> int: ...
+    def get_MaxConnectionsPerSource(self, conf: SystemctlConf) -> int: ...
+    def is_socket_accept_instances(self, conf: SystemctlConf) -> bool: ...
     def get_socket_service_from(self, conf: SystemctlConf) -> str: ...
     def do_start_socket_from(self, conf: SystemctlConf) -> bool: ...
     def create_socket(self, conf: SystemctlConf) -> Optional[socket.socket]: ...
@@ -452,15 +690,27 @@ class Systemctl:
     def get_User(self, conf: SystemctlConf) -> Optional[str]: ...
     def get_Group(self, conf: SystemctlConf) -> Optional[str]: ...
     def get_SupplementaryGroups(self, conf: SystemctlConf) -> List[str]: ...
+    def get_Nice(self, conf: SystemctlConf) -> Optional[int]: ...
+    def get_CPUAffinity(self, conf: SystemctlConf) -> List[int]: ...
+    def get_IOSchedulingClass(self, conf: SystemctlConf) -> Optional[str]: ...
+    def get_IOSchedulingPriority(self, conf: SystemctlConf) -> Optional[int]: ...
+    def get_OOMScoreAdjust(self, conf: SystemctlConf) -> Optional[int]: ...
+    def get_Limits(self, conf: SystemctlConf) -> List[Tuple[str, int, int]]: ...
+    def exec_context_from(self, conf: SystemctlConf) -> None: ...
     def skip_journal_log(self, conf: SystemctlConf) -> bool: ...
     def dup2_journal_log(self, conf: SystemctlConf) -> None: ...
+    def open_journal_files(self, conf: SystemctlConf) -> Tuple[TextIO, TextIO, TextIO]: ...
+    def journal_files_from(self, conf: SystemctlConf) -> Tuple[TextIO, TextIO, TextIO, str]: ...
+    def spawn_from(self, conf: SystemctlConf, cmd: List[str], env: Dict[str,str], setsid: bool = False) -> int: ...
+    def posix_spawn_from(self, conf: SystemctlConf, cmd: List[str], env: Dict[str,str], setsid: bool = False) -> Optional[int]: ...
+    def execve_child(self, conf: SystemctlConf, cmd: List[str], env: Dict[str,str], prepare: Optional[Callable[[], None]] = None) -> NoReturn: ...
     def execve_from(self, conf: SystemctlConf, cmd: List[str], env: Dict[str,str]) -> NoReturn:
         # cmd_args: Sequence[str]
         cmd_args: List[Union[str, bytes]]
     def test_start_unit(self, unit: str) -> None: ...
     def stop_modules(self, *modules: str) -> bool:
         units: List[str]
-    def stop_units(self, units: List[str]) -> bool: ...
+    def stop_units(self, units: List[str], maxjobs: Optional[int] = None) -> bool: ...
     def stop_unit(self, unit: str) -> bool: ...
     def get_TimeoutStopSec(self, conf: SystemctlConf) -> float: ...
     def stop_unit_from(self, conf: SystemctlConf) -> bool: ...
@@ -469,6 +719,7 @@ class Systemctl:
         pid: Optional[int]
     def do_stop_socket_from(self, conf: SystemctlConf) -> bool: ...
     def wait_vanished_pid(self, pid: int, timeout: float) -> bool: ...
+    def wait_vanished_pids(self, pids: List[int], timeout: float) -> bool: ...
     def reload_modules(self, *modules: str) -> bool:
         units: List[str]
     def reload_units(self, units: List[str]) -> bool: ...
@@ -505,12 +756,24 @@ class Systemctl:
     def kill_unit_from(self, conf: SystemctlConf) -> bool: ...
     def do_kill_unit_from(self, conf: SystemctlConf) -> bool: ...
     def _kill_pid(self, pid: int, kill_signal: Optional[int] = None) -> bool: ...
+    def init_cgroups(self) -> str: ...
+    def done_cgroups(self) -> None: ...
+    def cgroup_base(self) -> str: ...
+    def cgroup_from(self, conf: SystemctlConf) -> Optional[str]: ...
+    def cgroup_read(self, cgroup: str, name: str) -> str: ...
+    def cgroup_write(self, cgroup: str, name: str, value: str, quiet: bool = False) -> bool: ...
+    def cgroup_create_from(self, conf: SystemctlConf) -> Optional[str]: ...
+    def cgroup_join_from(self, conf: SystemctlConf) -> None: ...
+    def cgroup_pids_from(self, conf: SystemctlConf) -> List[int]: ...
+    def cgroup_kill_from(self, conf: SystemctlConf) -> bool: ...
+    def cgroup_remove_from(self, conf: SystemctlConf) -> None: ...
     def is_active_modules(self, *modules: str) -> List[str]:
         units: List[str]
         results: List[str]
     def is_active_from(self, conf: SystemctlConf) -> bool: ...
     def active_pid_from(self, conf: SystemctlConf) -> Optional[int]: ...
     def is_active_pid(self, pid: Optional[int]) -> Optional[int]: ...
+    def pid_alive(self, pid: int) -> bool: ...
     def get_active_unit(self, unit: str) -> str: ...
     def get_active_from(self, conf: SystemctlConf) -> str: ...
     def get_active_service_from(self, conf: Optional[SystemctlConf]) -> str: ...
@@ -585,7 +848,7 @@ class Systemctl:
         result: List[str]
     def list_dependencies_unit(self, unit: str) -> List[str]:
         result: List[str]
-    def list_dependencies(self, unit: str, indent: Optional[str] = None, mark: Optional[str] = None, loop: List[str] = []) -> Iterable[str]:
+    def list_dependencies(self, unit: str, indent: Optional[str] = None, mark: Optional[str] = None, loop: Optional[List[str]] = None) -> Iterable[str]:
         mapping: Dict[str,str]
     def get_dependencies_unit(self, unit: str, styles: Optional[List[str]] = None) -> Dict[str,str]:
         deps: Dict[str,str]
@@ -598,6 +861,10 @@ class Systemctl:
         deps: Dict[str,List[str]]
         deps_conf: List[SystemctlConf]
         result: List[Tuple[str,str]]
+    def analyze_modules(self, *modules: str) -> Union[bool, List[str]]: ...
+    def analyze_blame(self, timings: Dict[str, Dict[str, str]]) -> List[str]: ...
+    def analyze_critical_chain(self, timings: Dict[str, Dict[str, str]], units: List[str]) -> Union[bool, List[str]]: ...
+    def critical_chain(self, unit: str, timings: Dict[str, Dict[str, str]], base: int, indent: str = "", loop: Optional[List[str]] = None) -> List[str]: ...
     def sortedAfter(self, unitlist: List[str]) -> List[str]: ...
     def sortedBefore(self, unitlist: List[str]) -> List[str]: ...
     def system_daemon_reload(self) -> bool: ...
@@ -618,6 +885,9 @@ class Systemctl:
     def get_SendSIGHUP(self, conf: SystemctlConf) -> bool: ...
     def get_KillMode(self, conf: SystemctlConf) -> str: ...
     def get_KillSignal(self, conf: SystemctlConf) -> str: ...
+    def get_MemoryMax(self, conf: SystemctlConf) -> Optional[str]: ...
+    def get_CPUQuota(self, conf: SystemctlConf) -> Optional[str]: ...
+    def get_TasksMax(self, conf: SystemctlConf) -> Optional[str]: ...
     def _ignored_unit(self, unit: str, ignore_list: List[str]) -> bool: ...
     def default_services_modules(self, *modules: str) -> List[str]:
         results: List[str]
@@ -643,8 +913,8 @@ class Systemctl:
     def start_system_default(self, init: bool = False) -> bool: ...
     def start_target_system(self, target: str, init: bool = False) -> List[str]: ...
     def do_start_target_from(self, conf: SystemctlConf) -> bool: ...
-    def stop_system_default(self) -> bool: ...
-    def stop_target_system(self, target: str) -> List[str]: ...
+    def stop_system_default(self, init: bool = False) -> bool: ...
+    def stop_target_system(self, target: str, init: bool = False) -> List[str]: ...
     def do_stop_target_from(self, conf: SystemctlConf) -> bool: ...
     def do_reload_target_from(self, conf: SystemctlConf) -> bool: ...
     def reload_target_system(self, target: str) -> bool: ...
@@ -659,14 +929,36 @@ class Systemctl:
     def start_log_files(self, units: List[str]) -> None: ...
     def read_log_files(self, units: List[str]) -> None: ...
     def stop_log_files(self, units: List[str]) -> None: ...
+    def index_journal_log(self, unit: str, offset: int, stamp: Optional[float] = None) -> None: ...
+    def stop_journal_index(self, unit: str, remove: bool = False) -> None: ...
+    def start_journal_pipes(self, units: List[str]) -> None: ...
+    def tee_journal_log(self, unit: str, content: bytes) -> None: ...
+    def stop_journal_pipes(self, units: List[str]) -> None: ...
     def get_StartLimitBurst(self, conf: SystemctlConf) -> int: ...
     def get_StartLimitIntervalSec(self, conf: SystemctlConf, maximum: Optional[int] = None) -> float: ...
     def get_RestartSec(self, conf: SystemctlConf, maximum: Optional[int] = None) -> float: ...
+    def get_RestartSteps(self, conf: SystemctlConf) -> int: ...
+    def get_RestartMaxDelaySec(self, conf: SystemctlConf) -> Optional[float]: ...
+    def get_RestartDelay(self, conf: SystemctlConf, restarts: int = 0) -> float: ...
     def restart_failed_units(self, units: List[str], maximum: Optional[int] = None) -> List[str]:
         restart_done: List[str]
+    def init_loop_timer(self, deadline: float, unit: str = ...) -> None: ...
+    def init_loop_timeout(self, timeout: float) -> float: ...
+    def init_loop_events(self) -> bool: ...
+    def init_loop_events_done(self) -> None: ...
+    def init_loop_wait(self, timeout: float) -> List[int]: ...
+    def control_socket_file(self) -> str: ...
+    def control_options(self) -> Dict[str, Any]: ...
+    def control_request(self, request: Dict[str, Any]) -> int: ...
     def init_loop_until_stop(self, units: List[str]) -> Optional[str]:
         result: Optional[str]
+    def metrics_textfile(self) -> str: ...
+    def metrics_text(self, units: List[str]) -> str: ...
+    def write_metrics_textfile(self, units: List[str]) -> bool: ...
+    def remove_metrics_textfile(self) -> None: ...
     def system_reap_zombies(self) -> int: ...
+    def reap_zombies(self) -> List[int]: ...
+    def count_running_procs(self) -> int: ...
     def sysinit_status(self, **status: Optional[str]) -> None: ...
     def sysinit_target(self) -> SystemctlConf: ...
     def is_system_running(self) -> str: ...
@@ -674,7 +966,7 @@ class Systemctl:
     def wait_system(self, target: Optional[str] = None) -> None: ...
     def is_running_unit_from(self, conf: SystemctlConf) -> bool: ...
     def is_running_unit(self, unit: str) -> bool: ...
-    def pidlist_of(self, pid: Optional[int]) -> List[int]: ...
+    def pidlist_of(self, pid: Optional[int], proctable: Optional[ProcTable] = None) -> List[int]: ...
     def echo(self, *targets: str) -> str: ...
     def killall(self, *targets: str) -> bool: ...
     def force_ipv4(self, *args: str) -> None:
@@ -691,4 +983,6 @@ class Systemctl:
 def print_result(result: Union[None,bool,int,str,List[str],Dict[str,str],Generator[str,None,None]]) -> int:
     def logg_info(*msg: Union[None,bool,int,str,List[str],Dict[str,str],Generator[str,None,None]]) -> None: ...
     def logg_debug(*msg: Union[None,bool,int,str,List[str],Dict[str,str],Generator[str,None,None]]) -> None: ...
+def command_of(systemctl: Systemctl, command: str) -> Optional[Callable[..., Any]]: ...
+def control_client(systemctl: Systemctl, command: str, modules: List[str]) -> Optional[int]: ...
 